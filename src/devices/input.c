@@ -3,14 +3,18 @@
 #include "devices/intq.h"
 #include "devices/serial.h"
 
+/* Size of the input buffer, in bytes.  Must be a power of 2. */
+#define INPUT_BUFSIZE 256
+
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
+static uint8_t buffer_data[INPUT_BUFSIZE];
 
 /* Initializes the input buffer. */
 void
 input_init (void) 
 {
-  intq_init (&buffer);
+  intq_init (&buffer, buffer_data, sizeof buffer_data);
 }
 
 /* Adds a key to the input buffer.
@@ -41,6 +45,24 @@ input_getc (void)
   return key;
 }
 
+/* Retrieves up to SIZE keys from the input buffer into BUF and
+   returns the number retrieved.  If the buffer is empty, waits
+   for a key to be pressed, then retrieves as many keys as are
+   available. */
+size_t
+input_read (uint8_t *buf, size_t size) 
+{
+  enum intr_level old_level;
+  size_t cnt;
+
+  old_level = intr_disable ();
+  cnt = intq_read (&buffer, buf, size);
+  serial_notify ();
+  intr_set_level (old_level);
+
+  return cnt;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
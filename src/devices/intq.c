@@ -1,17 +1,23 @@
 #include "devices/intq.h"
 #include <debug.h>
+#include <string.h>
 #include "threads/thread.h"
 
-static int next (int pos);
+static size_t next (const struct intq *q, size_t pos);
 static void wait (struct intq *q, struct thread **waiter);
 static void signal (struct intq *q, struct thread **waiter);
 
-/* Initializes interrupt queue Q. */
+/* Initializes interrupt queue Q to use the SIZE bytes in BUF,
+   which must remain valid as long as Q is in use.  SIZE must be
+   a power of 2, at least 2.  Q can hold up to SIZE - 1 bytes. */
 void
-intq_init (struct intq *q) 
+intq_init (struct intq *q, uint8_t *buf, size_t size) 
 {
+  ASSERT (size >= 2 && (size & (size - 1)) == 0);
   lock_init (&q->lock);
   q->not_full = q->not_empty = NULL;
+  q->buf = buf;
+  q->size = size;
   q->head = q->tail = 0;
 }
 
@@ -28,7 +34,7 @@ bool
 intq_full (const struct intq *q) 
 {
   ASSERT (intr_get_level () == INTR_OFF);
-  return next (q->head) == q->tail;
+  return next (q, q->head) == q->tail;
 }
 
 /* Removes a byte from Q and returns it.
@@ -49,7 +55,7 @@ intq_getc (struct intq *q)
     }
   
   byte = q->buf[q->tail];
-  q->tail = next (q->tail);
+  q->tail = next (q, q->tail);
   signal (q, &q->not_full);
   return byte;
 }
@@ -70,15 +76,87 @@ intq_putc (struct intq *q, uint8_t byte)
     }
 
   q->buf[q->head] = byte;
-  q->head = next (q->head);
+  q->head = next (q, q->head);
   signal (q, &q->not_empty);
 }
 
-/* Returns the position after POS within an intq. */
-static int
-next (int pos) 
+/* Removes up to SIZE bytes from Q, storing them in BUF, and
+   returns the number of bytes removed.  If Q is empty, sleeps
+   until a byte is added, then removes as many bytes as are
+   available, waking a waiting writer at most once.
+   When called from an interrupt handler, returns 0 at once if Q
+   is empty. */
+size_t
+intq_read (struct intq *q, uint8_t *buf, size_t size) 
 {
-  return (pos + 1) % INTQ_BUFSIZE;
+  size_t cnt, first;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  if (size == 0 || (intr_context () && intq_empty (q)))
+    return 0;
+  while (intq_empty (q)) 
+    {
+      lock_acquire (&q->lock);
+      wait (q, &q->not_empty);
+      lock_release (&q->lock);
+    }
+
+  /* Copy out, in two pieces if the data wraps around. */
+  cnt = (q->head - q->tail) & (q->size - 1);
+  if (cnt > size)
+    cnt = size;
+  first = q->size - q->tail;
+  if (first > cnt)
+    first = cnt;
+  memcpy (buf, q->buf + q->tail, first);
+  memcpy (buf + first, q->buf, cnt - first);
+  q->tail = (q->tail + cnt) & (q->size - 1);
+
+  signal (q, &q->not_full);
+  return cnt;
+}
+
+/* Adds up to SIZE bytes from BUF to the end of Q and returns
+   the number of bytes added.  If Q is full, sleeps until a byte
+   is removed, then adds as many bytes as there is room for,
+   waking a waiting reader at most once.
+   When called from an interrupt handler, returns 0 at once if Q
+   is full. */
+size_t
+intq_write (struct intq *q, const uint8_t *buf, size_t size) 
+{
+  size_t cnt, first;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  if (size == 0 || (intr_context () && intq_full (q)))
+    return 0;
+  while (intq_full (q))
+    {
+      lock_acquire (&q->lock);
+      wait (q, &q->not_full);
+      lock_release (&q->lock);
+    }
+
+  /* Copy in, in two pieces if the free space wraps around. */
+  cnt = (q->tail - q->head - 1) & (q->size - 1);
+  if (cnt > size)
+    cnt = size;
+  first = q->size - q->head;
+  if (first > cnt)
+    first = cnt;
+  memcpy (q->buf + q->head, buf, first);
+  memcpy (q->buf, buf + first, cnt - first);
+  q->head = (q->head + cnt) & (q->size - 1);
+
+  signal (q, &q->not_empty);
+  return cnt;
+}
+
+/* Returns the position after POS within Q. */
+static size_t
+next (const struct intq *q, size_t pos) 
+{
+  return (pos + 1) & (q->size - 1);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
@@ -1,6 +1,7 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
+#include <stddef.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
@@ -17,7 +18,8 @@
    protect kernel threads from one another, not from interrupt
    handlers. */
 
-/* Queue buffer size, in bytes. */
+/* Usual queue buffer size, in bytes.  Queue buffers may be any
+   power of 2 in size. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
@@ -29,15 +31,18 @@ struct intq
     struct thread *not_empty;   /* Thread waiting for not-empty condition. */
 
     /* Queue. */
-    uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
-    int head;                   /* New data is written here. */
-    int tail;                   /* Old data is read here. */
+    uint8_t *buf;               /* Buffer. */
+    size_t size;                /* Buffer size in bytes, a power of 2. */
+    size_t head;                /* New data is written here. */
+    size_t tail;                /* Old data is read here. */
   };
 
-void intq_init (struct intq *);
+void intq_init (struct intq *, uint8_t *buf, size_t size);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
 void intq_putc (struct intq *, uint8_t);
+size_t intq_read (struct intq *, uint8_t *, size_t);
+size_t intq_write (struct intq *, const uint8_t *, size_t);
 
 #endif /* devices/intq.h */
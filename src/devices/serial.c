@@ -5,6 +5,7 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 
@@ -33,6 +34,17 @@
 #define MCR_REG (IO_BASE + 4)   /* MODEM Control Register. */
 #define LSR_REG (IO_BASE + 5)   /* Line Status Register (read-only). */
 
+/* Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0           /* FIFOs enabled (both bits set). */
+
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable FIFOs. */
+#define FCR_CLEAR_RX 0x02       /* Clear receive FIFO. */
+#define FCR_CLEAR_TX 0x04       /* Clear transmit FIFO. */
+
+/* Size of the 16550A transmit FIFO, in bytes. */
+#define TX_FIFO_SIZE 16
+
 /* Interrupt Enable Register bits. */
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
@@ -51,11 +63,26 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
+/* Data to be transmitted.
+   Until interrupt-driven I/O is set up, the queue goes unused
+   and uses a small static buffer.  After that, it uses a buffer
+   of serial_txq_size bytes, if one can be allocated. */
 static struct intq txq;
+static uint8_t txq_initial_buf[INTQ_BUFSIZE];
+
+/* Size of the transmit queue, in bytes, once interrupt-driven
+   I/O is set up.  Controlled by kernel command-line option
+   "-serial-txq". */
+size_t serial_txq_size = 4096;
+
+/* Number of bytes that may be written to the transmitter at
+   once when THR is empty: TX_FIFO_SIZE if the UART has a
+   working FIFO, otherwise 1. */
+static size_t tx_burst;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static void fill_tx_fifo (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -68,10 +95,15 @@ init_poll (void)
 {
   ASSERT (mode == UNINIT);
   outb (IER_REG, 0);                    /* Turn off all interrupts. */
-  outb (FCR_REG, 0);                    /* Disable FIFO. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR_RX | FCR_CLEAR_TX);
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
+
+  /* Only a 16550A (or better) reports working FIFOs.  An 8250
+     or 16450 has none, and a 16550 has a broken one. */
+  tx_burst = (inb (IIR_REG) & IIR_FIFO) == IIR_FIFO ? TX_FIFO_SIZE : 1;
+
+  intq_init (&txq, txq_initial_buf, sizeof txq_initial_buf);
   mode = POLL;
 } 
 
@@ -87,6 +119,21 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  /* Switch to a larger transmit queue, rounding its size up to
+     a power of 2.  In polling mode the queue is always empty, so
+     nothing is lost. */
+  if (serial_txq_size > sizeof txq_initial_buf)
+    {
+      size_t size = sizeof txq_initial_buf;
+      uint8_t *buf;
+
+      while (size < serial_txq_size)
+        size *= 2;
+      buf = malloc (size);
+      if (buf != NULL)
+        intq_init (&txq, buf, size);
+    }
+
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
   mode = QUEUE;
   old_level = intr_disable ();
@@ -97,32 +144,61 @@ serial_init_queue (void)
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) 
+{
+  serial_putbuf (&byte, 1);
+}
+
+/* Sends the SIZE bytes in BUF to the serial port.
+   Interrupts are disabled and the interrupt enable register is
+   updated once for the whole buffer, rather than once per
+   byte. */
+void
+serial_putbuf (const uint8_t *buf, size_t size) 
 {
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (size-- > 0)
+        putc_poll (*buf++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      /* Otherwise, queue the bytes and update the interrupt
+         enable register. */
+      while (size > 0)
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          size_t cnt;
+
+          if (intq_full (&txq)) 
+            {
+              if (old_level == INTR_OFF)
+                {
+                  /* Interrupts are off and the transmit queue is
+                     full.  If we wanted to wait for the queue to
+                     empty, we'd have to reenable interrupts.
+                     That's impolite, so we'll send a burst via
+                     polling instead. */
+                  while ((inb (LSR_REG) & LSR_THRE) == 0)
+                    continue;
+                  fill_tx_fifo ();
+                }
+              else
+                {
+                  /* intq_write() will wait for the queue to
+                     drain, so make sure the transmit interrupt
+                     is enabled to drain it. */
+                  write_ier ();
+                }
+            }
+          cnt = intq_write (&txq, buf, size);
+          buf += cnt;
+          size -= cnt;
         }
-
-      intq_putc (&txq, byte); 
       write_ier ();
     }
   
@@ -136,7 +212,11 @@ serial_flush (void)
 {
   enum intr_level old_level = intr_disable ();
   while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+    {
+      while ((inb (LSR_REG) & LSR_THRE) == 0)
+        continue;
+      fill_tx_fifo ();
+    }
   intr_set_level (old_level);
 }
 
@@ -205,6 +285,23 @@ putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Moves bytes from the transmit queue to the UART, as many as
+   the transmitter can accept at once.  THR must be empty. */
+static void
+fill_tx_fifo (void) 
+{
+  uint8_t buf[TX_FIFO_SIZE];
+  size_t cnt, i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (intq_empty (&txq))
+    return;
+  cnt = intq_read (&txq, buf, tx_burst);
+  for (i = 0; i < cnt; i++)
+    outb (THR_REG, buf[i]);
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
@@ -218,10 +315,11 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* If the transmitter is empty, refill it.  With the FIFO
+     enabled, THRE means that the whole FIFO is empty, so this
+     sends up to TX_FIFO_SIZE bytes per interrupt. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0) 
+    fill_tx_fifo ();
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
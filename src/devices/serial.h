@@ -1,10 +1,16 @@
 #ifndef DEVICES_SERIAL_H
 #define DEVICES_SERIAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/* Transmit queue size in bytes, rounded up to a power of 2.
+   Controlled by kernel command-line option "-serial-txq". */
+extern size_t serial_txq_size;
+
 void serial_init_queue (void);
 void serial_putc (uint8_t);
+void serial_putbuf (const uint8_t *, size_t);
 void serial_flush (void);
 void serial_notify (void);
 
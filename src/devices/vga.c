@@ -26,6 +26,7 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+static void put_char (uint8_t c, enum intr_level old_level);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -50,13 +51,38 @@ init (void)
    characters in the conventional ways.  */
 void
 vga_putc (int c)
+{
+  char ch = c;
+  vga_putbuf (&ch, 1);
+}
+
+/* Writes the SIZE characters in BUF to the VGA text display,
+   interpreting control characters in the conventional ways.
+   The hardware cursor is moved only once, after the last
+   character. */
+void
+vga_putbuf (const char *buf, size_t size)
 {
   /* Disable interrupts to lock out interrupt handlers
      that might write to the console. */
   enum intr_level old_level = intr_disable ();
 
   init ();
-  
+  while (size-- > 0)
+    put_char (*buf++, old_level);
+
+  /* Update cursor position. */
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Writes C to the framebuffer without moving the hardware
+   cursor.  Interrupts must be off; OLD_LEVEL is the level to
+   restore while beeping. */
+static void
+put_char (uint8_t c, enum intr_level old_level)
+{
   switch (c) 
     {
     case '\n':
@@ -95,11 +121,6 @@ vga_putc (int c)
         newline ();
       break;
     }
-
-  /* Update cursor position. */
-  move_cursor ();
-
-  intr_set_level (old_level);
 }
 
 /* Clears the screen and moves the cursor to the upper left. */
@@ -1,6 +1,7 @@
-/* cat.c
+/* cp.c
 
-Copies one file to another. */
+Copies one file to another.  The kernel does the copying, so the
+data never passes through this program. */
 
 #include <stdio.h>
 #include <syscall.h>
@@ -9,6 +10,7 @@ int
 main (int argc, char *argv[]) 
 {
   int in_fd, out_fd;
+  int size;
 
   if (argc != 3) 
     {
@@ -25,7 +27,8 @@ main (int argc, char *argv[])
     }
 
   /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  size = filesize (in_fd);
+  if (!create (argv[2], size)) 
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
@@ -38,17 +41,10 @@ main (int argc, char *argv[])
     }
 
   /* Copy data. */
-  for (;;) 
+  if (copy_range (in_fd, out_fd, size) != size) 
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
+      printf ("%s: write failed\n", argv[2]);
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
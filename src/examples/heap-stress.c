@@ -0,0 +1,186 @@
+/* heap-stress.c
+
+   Exercises malloc(), realloc(), and free() and reports how many
+   CPU cycles each takes on average, and how far the heap grew.
+
+   The first phase allocates many small blocks and then frees
+   them all.  The second phase keeps a fixed number of blocks of
+   random sizes live, repeatedly freeing, reallocating, or
+   replacing one at random.  Every block is filled with a pattern
+   that is checked before the block is freed or resized, so heap
+   corruption is reported as a failure.
+
+   Usage: heap-stress [OPERATIONS] */
+
+#include <cpu.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Number of blocks kept live in the churn phase. */
+#define SLOT_CNT 512
+
+/* Largest block size in the churn phase. */
+#define MAX_SIZE 4096
+
+/* Number of blocks in the bulk phase. */
+#define BULK_CNT 4096
+
+struct slot
+  {
+    unsigned char *p;           /* Block, or a null pointer. */
+    size_t size;                /* Block size in bytes. */
+  };
+
+static struct slot slots[SLOT_CNT];
+static void *bulk[BULK_CNT];
+
+/* Fills the block in S with a pattern derived from its index
+   IDX, starting at byte offset OFS. */
+static void
+fill (struct slot *s, int idx, size_t ofs)
+{
+  size_t i;
+  for (i = ofs; i < s->size; i++)
+    s->p[i] = idx + i;
+}
+
+/* Checks the first SIZE bytes of the block in S against the
+   pattern written by fill().  Exits if it does not match. */
+static void
+check (struct slot *s, int idx, size_t size)
+{
+  size_t i;
+  for (i = 0; i < size; i++)
+    if (s->p[i] != (unsigned char) (idx + i))
+      {
+        printf ("heap-stress: block %d corrupted at byte %zu\n", idx, i);
+        exit (1);
+      }
+}
+
+/* Returns a random block size between 1 and MAX, favoring small
+   sizes the way real programs do. */
+static size_t
+random_size (size_t max)
+{
+  unsigned long r = random_ulong ();
+  if (r % 4 != 0)
+    max = max < 64 ? max : 64;
+  return (r >> 2) % max + 1;
+}
+
+/* Prints the average cycles per operation for CNT operations
+   that took CYCLES cycles. */
+static void
+report (const char *what, uint64_t cycles, int cnt)
+{
+  if (cnt > 0)
+    printf ("%-8s %8d ops, %8llu cycles/op\n",
+            what, cnt, (unsigned long long) (cycles / cnt));
+}
+
+int
+main (int argc, char *argv[])
+{
+  int op_cnt = argc > 1 ? atoi (argv[1]) : 100000;
+  uint64_t malloc_cycles = 0, free_cycles = 0, realloc_cycles = 0;
+  int malloc_cnt = 0, free_cnt = 0, realloc_cnt = 0;
+  uint8_t *heap_start, *heap_end;
+  uint64_t start;
+  int i;
+
+  random_init (0);
+
+  /* Allocate a block first so that the heap is set up, then
+     measure its growth from there. */
+  free (malloc (1));
+  heap_start = sbrk (0);
+
+  /* Bulk phase. */
+  start = rdtsc ();
+  for (i = 0; i < BULK_CNT; i++)
+    {
+      bulk[i] = malloc (random_size (256));
+      if (bulk[i] == NULL)
+        {
+          printf ("heap-stress: out of memory after %d blocks\n", i);
+          return 1;
+        }
+    }
+  malloc_cycles += rdtsc () - start;
+  malloc_cnt += BULK_CNT;
+
+  start = rdtsc ();
+  for (i = 0; i < BULK_CNT; i++)
+    free (bulk[i]);
+  free_cycles += rdtsc () - start;
+  free_cnt += BULK_CNT;
+
+  /* Churn phase. */
+  for (i = 0; i < op_cnt; i++)
+    {
+      int idx = random_ulong () % SLOT_CNT;
+      struct slot *s = &slots[idx];
+
+      if (s->p == NULL)
+        {
+          s->size = random_size (MAX_SIZE);
+          start = rdtsc ();
+          s->p = malloc (s->size);
+          malloc_cycles += rdtsc () - start;
+          malloc_cnt++;
+          if (s->p == NULL)
+            {
+              printf ("heap-stress: malloc(%zu) failed\n", s->size);
+              return 1;
+            }
+          fill (s, idx, 0);
+        }
+      else if (random_ulong () % 2)
+        {
+          size_t old_size = s->size;
+          unsigned char *p;
+
+          check (s, idx, old_size);
+          s->size = random_size (MAX_SIZE);
+          start = rdtsc ();
+          p = realloc (s->p, s->size);
+          realloc_cycles += rdtsc () - start;
+          realloc_cnt++;
+          if (p == NULL)
+            {
+              printf ("heap-stress: realloc(%zu) failed\n", s->size);
+              return 1;
+            }
+          s->p = p;
+          check (s, idx, old_size < s->size ? old_size : s->size);
+          fill (s, idx, 0);
+        }
+      else
+        {
+          check (s, idx, s->size);
+          start = rdtsc ();
+          free (s->p);
+          free_cycles += rdtsc () - start;
+          free_cnt++;
+          s->p = NULL;
+        }
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    if (slots[i].p != NULL)
+      {
+        check (&slots[i], i, slots[i].size);
+        free (slots[i].p);
+      }
+
+  heap_end = sbrk (0);
+  report ("malloc", malloc_cycles, malloc_cnt);
+  report ("realloc", realloc_cycles, realloc_cnt);
+  report ("free", free_cycles, free_cnt);
+  printf ("heap grew by %zu bytes\n", (size_t) (heap_end - heap_start));
+  return 0;
+}
@@ -0,0 +1,59 @@
+/* sysenter-bench.c
+
+   Measures the latency of a null system call entered with
+   "int $0x30" and, if the kernel allows it, with SYSENTER.
+
+   The call used is the one that reports whether SYSENTER is
+   allowed, which does no other work, so its cost is that of
+   entering and leaving the kernel.  The program reports the
+   average CPU cycles per call for each entry method.
+
+   Usage: sysenter-bench [CALLS] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Makes CNT null system calls and returns the average cycles
+   per call. */
+static uint64_t
+time_calls (int cnt)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    sysenter_allowed ();
+  return (rdtsc () - start) / cnt;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = argc > 1 ? atoi (argv[1]) : 100000;
+  uint64_t int_cycles, sysenter_cycles;
+
+  if (cnt <= 0)
+    cnt = 1;
+
+  syscall_use_sysenter (false);
+  int_cycles = time_calls (cnt);
+  printf ("int $0x30 %8d calls, %8llu cycles/call\n",
+          cnt, (unsigned long long) int_cycles);
+
+  if (!syscall_use_sysenter (true))
+    {
+      printf ("sysenter  not available\n");
+      return 0;
+    }
+  sysenter_cycles = time_calls (cnt);
+  printf ("sysenter  %8d calls, %8llu cycles/call\n",
+          cnt, (unsigned long long) sysenter_cycles);
+  if (sysenter_cycles > 0)
+    printf ("sysenter is %llu.%02llu times as fast\n",
+            (unsigned long long) (int_cycles / sysenter_cycles),
+            (unsigned long long) (int_cycles * 100 / sysenter_cycles % 100));
+  return 0;
+}
@@ -0,0 +1,124 @@
+/* sysring-bench.c
+
+   Compares the cost of making system calls one trap at a time
+   with queueing them in a system call ring and submitting a
+   whole ring with one trap.
+
+   Each test makes the same calls both ways and reports the
+   average CPU cycles per call and the number of calls completed
+   per million cycles.  The "tell" test measures little but the
+   trap itself; the "pread" test reads one byte of FILE per call.
+
+   Usage: sysring-bench FILE [CALLS] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+static struct sys_ring ring;
+
+/* Prints the cost of CNT calls that took CYCLES cycles. */
+static void
+report (const char *test, const char *how, uint64_t cycles, int cnt)
+{
+  if (cycles == 0)
+    cycles = 1;
+  printf ("%-6s %-8s %8d calls, %8llu cycles/call, %8llu calls/Mcycle\n",
+          test, how, cnt, (unsigned long long) (cycles / cnt),
+          (unsigned long long) (cnt * 1000000ULL / cycles));
+}
+
+/* Makes CNT calls to CALL_NR with arguments ARG0 through ARG3
+   through the ring, a ring at a time.  Exits if any call's
+   result differs from EXPECT.  Returns the cycles taken. */
+static uint64_t
+run_ring (int cnt, int call_nr, int arg0, int arg1, int arg2, int arg3,
+          int expect)
+{
+  uint64_t start = rdtsc ();
+  int done = 0;
+
+  sys_ring_init (&ring);
+  while (done < cnt)
+    {
+      struct sys_op *op;
+      int queued;
+
+      for (queued = 0; done + queued < cnt; queued++)
+        if (sys_ring_queue (&ring, call_nr, arg0, arg1, arg2, arg3) == NULL)
+          break;
+      if (sys_ring_submit (&ring) != queued)
+        {
+          printf ("sysring-bench: submit failed\n");
+          exit (1);
+        }
+      while ((op = sys_ring_reap (&ring)) != NULL)
+        if (op->result != expect)
+          {
+            printf ("sysring-bench: call returned %d, expected %d\n",
+                    op->result, expect);
+            exit (1);
+          }
+      done += queued;
+    }
+  return rdtsc () - start;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt;
+  int fd;
+  char c;
+  uint64_t start, cycles;
+  int i;
+
+  if (argc < 2)
+    {
+      printf ("usage: sysring-bench FILE [CALLS]\n");
+      return 1;
+    }
+  cnt = argc > 2 ? atoi (argv[2]) : 10000;
+  if (cnt <= 0)
+    cnt = 1;
+
+  fd = open (argv[1]);
+  if (fd < 0)
+    {
+      printf ("sysring-bench: %s: open failed\n", argv[1]);
+      return 1;
+    }
+  if (filesize (fd) < 1)
+    {
+      printf ("sysring-bench: %s: file is empty\n", argv[1]);
+      return 1;
+    }
+
+  /* Trap only. */
+  start = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    tell (fd);
+  cycles = rdtsc () - start;
+  report ("tell", "trap", cycles, cnt);
+  cycles = run_ring (cnt, SYS_TELL, fd, 0, 0, 0, 0);
+  report ("tell", "ring", cycles, cnt);
+
+  /* One-byte reads. */
+  start = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    if (pread (fd, &c, 1, 0) != 1)
+      {
+        printf ("sysring-bench: pread failed\n");
+        return 1;
+      }
+  cycles = rdtsc () - start;
+  report ("pread", "trap", cycles, cnt);
+  cycles = run_ring (cnt, SYS_PREAD, fd, (int) &c, 1, 0, 1);
+  report ("pread", "ring", cycles, cnt);
+
+  close (fd);
+  return 0;
+}
@@ -5,6 +5,7 @@
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "threads/kmem.h"
 #include "threads/malloc.h"
 
 /* Identifies an inode. */
@@ -53,15 +54,34 @@ byte_to_sector (const struct inode *inode, off_t pos)
     return -1;
 }
 
+/* Returns the number of whole sectors, starting at the one that
+   holds byte offset POS within INODE, that can be transferred in
+   one request for a transfer of SIZE bytes at POS.  POS must be
+   at a sector boundary.  Because a file's data sectors are
+   allocated contiguously, all of them can be. */
+static size_t
+whole_sectors (const struct inode *inode, off_t pos, off_t size) 
+{
+  off_t inode_left = inode->data.length - pos;
+  off_t left = size < inode_left ? size : inode_left;
+
+  ASSERT (pos % BLOCK_SECTOR_SIZE == 0);
+  return left > 0 ? left / BLOCK_SECTOR_SIZE : 0;
+}
+
 /* List of open inodes, so that opening a single inode twice
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's. */
+static struct kmem_cache inode_cache;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  kmem_cache_init (&inode_cache, "inode", sizeof (struct inode), NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -127,7 +147,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = kmem_cache_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -181,7 +201,7 @@ inode_close (struct inode *inode)
                             bytes_to_sectors (inode->data.length)); 
         }
 
-      free (inode); 
+      kmem_cache_free (&inode_cache, inode);
     }
 }
 
@@ -196,7 +216,10 @@ inode_remove (struct inode *inode)
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
    Returns the number of bytes actually read, which may be less
-   than SIZE if an error occurs or end of file is reached. */
+   than SIZE if an error occurs or end of file is reached.
+   Runs of whole sectors are read directly into BUFFER with one
+   request each; only partial sectors are copied through a bounce
+   buffer. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) 
 {
@@ -222,8 +245,11 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
+          /* Read full sectors directly into caller's buffer. */
+          size_t sector_cnt = whole_sectors (inode, offset, size);
+          block_read_multiple (fs_device, sector_idx, sector_cnt,
+                               buffer + bytes_read);
+          chunk_size = sector_cnt * BLOCK_SECTOR_SIZE;
         }
       else 
         {
@@ -253,7 +279,10 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
    Returns the number of bytes actually written, which may be
    less than SIZE if end of file is reached or an error occurs.
    (Normally a write at end of file would extend the inode, but
-   growth is not yet implemented.) */
+   growth is not yet implemented.)
+   Runs of whole sectors are written directly from BUFFER with
+   one request each; only partial sectors are copied through a
+   bounce buffer. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
                 off_t offset) 
@@ -283,8 +312,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
+          /* Write full sectors directly to disk. */
+          size_t sector_cnt = whole_sectors (inode, offset, size);
+          block_write_multiple (fs_device, sector_idx, sector_cnt,
+                                buffer + bytes_written);
+          chunk_size = sector_cnt * BLOCK_SECTOR_SIZE;
         }
       else 
         {
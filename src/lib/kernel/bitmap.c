@@ -69,6 +69,36 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns the index of the first bit in B at or after START
+   that is set to VALUE, or B's size if there is none.  Works a
+   whole element at a time: an element with no bit set to VALUE
+   is skipped with a single compare, and find-first-set locates
+   the bit within the element that has one. */
+static size_t
+next_bit (const struct bitmap *b, size_t start, bool value)
+{
+  size_t i = elem_idx (start);
+  size_t last = elem_cnt (b->bit_cnt);
+  elem_type flip = value ? 0 : (elem_type) -1;
+  elem_type x;
+
+  if (start >= b->bit_cnt)
+    return b->bit_cnt;
+
+  /* Ignore the bits before START in the first element. */
+  x = (b->bits[i] ^ flip) & ~(bit_mask (start) - 1);
+  while (x == 0)
+    {
+      if (++i >= last)
+        return b->bit_cnt;
+      x = b->bits[i] ^ flip;
+    }
+
+  /* Bits past the end of the last element may be either value. */
+  start = i * ELEM_BITS + (__builtin_ffsl (x) - 1);
+  return start < b->bit_cnt ? start : b->bit_cnt;
+}
+
 /* Creation and destruction. */
 
 /* Creates and returns a pointer to a newly allocated bitmap with room for
@@ -250,16 +280,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return cnt > 0 && next_bit (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -298,13 +323,27 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      /* Jump from each run of VALUE bits to the next, skipping
+         runs that are too short. */
+      for (;;)
+        {
+          size_t end;
+
+          i = next_bit (b, i, value);
+          if (i > last)
+            break;
+          end = next_bit (b, i, !value);
+          if (end - i >= cnt)
+            return i;
+          i = end;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -325,6 +364,53 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)
   return idx;
 }
 
+/* Next-fit search.
+
+   Allocators that repeatedly take a few bits at a time from the
+   front of a bitmap rescan the same allocated prefix on every
+   call.  These functions instead start at *CURSOR, a position
+   kept by the caller, wrap around to the beginning if nothing
+   fits between there and the end, and on success leave *CURSOR
+   just past the group found.  A new cursor should start at 0. */
+
+/* Finds and returns the starting index of the first group of CNT
+   consecutive bits in B at or after *CURSOR, or failing that
+   before it, that are all set to VALUE, and advances *CURSOR
+   past the group.
+   If there is no such group, returns BITMAP_ERROR and leaves
+   *CURSOR unchanged. */
+size_t
+bitmap_scan_next_fit (const struct bitmap *b, size_t *cursor, size_t cnt,
+                      bool value) 
+{
+  size_t start, idx;
+
+  ASSERT (b != NULL);
+  ASSERT (cursor != NULL);
+
+  start = *cursor <= b->bit_cnt ? *cursor : 0;
+  idx = bitmap_scan (b, start, cnt, value);
+  if (idx == BITMAP_ERROR && start > 0) 
+    idx = bitmap_scan (b, 0, cnt, value);
+  if (idx != BITMAP_ERROR)
+    *cursor = idx + cnt;
+  return idx;
+}
+
+/* Like bitmap_scan_next_fit(), but also flips the bits in the
+   group found to !VALUE.
+   Bits are set atomically, but testing bits is not atomic with
+   setting them. */
+size_t
+bitmap_scan_and_flip_next_fit (struct bitmap *b, size_t *cursor, size_t cnt,
+                               bool value) 
+{
+  size_t idx = bitmap_scan_next_fit (b, cursor, cnt, value);
+  if (idx != BITMAP_ERROR) 
+    bitmap_set_multiple (b, idx, cnt, !value);
+  return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
@@ -1,6 +1,7 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
@@ -8,7 +9,20 @@
 #include "threads/synch.h"
 
 static void vprintf_helper (char, void *);
-static void putchar_have_lock (uint8_t c);
+static void putbuf_have_lock (const char *, size_t);
+
+/* Size of the buffer that vprintf() formats into before passing
+   output to the serial and vga layers. */
+#define PRINTF_BUF_SIZE 128
+
+/* Output of one vprintf() call, collected so that it reaches the
+   devices in batches rather than a character at a time. */
+struct printf_buf
+  {
+    char buf[PRINTF_BUF_SIZE];  /* Pending characters. */
+    size_t len;                 /* Number of pending characters. */
+    int char_cnt;               /* Total characters output. */
+  };
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -64,6 +78,7 @@ void
 console_init (void) 
 {
   lock_init (&console_lock);
+  lock_set_name (&console_lock, "console");
   use_console_lock = true;
 }
 
@@ -125,13 +140,17 @@ console_locked_by_current_thread (void)
 int
 vprintf (const char *format, va_list args) 
 {
-  int char_cnt = 0;
+  struct printf_buf pb;
+
+  pb.len = 0;
+  pb.char_cnt = 0;
 
   acquire_console ();
-  __vprintf (format, args, vprintf_helper, &char_cnt);
+  __vprintf (format, args, vprintf_helper, &pb);
+  putbuf_have_lock (pb.buf, pb.len);
   release_console ();
 
-  return char_cnt;
+  return pb.char_cnt;
 }
 
 /* Writes string S to the console, followed by a new-line
@@ -140,9 +159,8 @@ int
 puts (const char *s) 
 {
   acquire_console ();
-  while (*s != '\0')
-    putchar_have_lock (*s++);
-  putchar_have_lock ('\n');
+  putbuf_have_lock (s, strlen (s));
+  putbuf_have_lock ("\n", 1);
   release_console ();
 
   return 0;
@@ -153,8 +171,7 @@ void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  putbuf_have_lock (buffer, n);
   release_console ();
 }
 
@@ -162,30 +179,49 @@ putbuf (const char *buffer, size_t n)
 int
 putchar (int c) 
 {
+  char ch = c;
+
   acquire_console ();
-  putchar_have_lock (c);
+  putbuf_have_lock (&ch, 1);
   release_console ();
   
   return c;
 }
 
-/* Helper function for vprintf(). */
+/* Helper function for vprintf().
+   Adds C to the printf_buf in PB_, passing the buffer on to the
+   devices when it fills up. */
 static void
-vprintf_helper (char c, void *char_cnt_) 
+vprintf_helper (char c, void *pb_) 
 {
-  int *char_cnt = char_cnt_;
-  (*char_cnt)++;
-  putchar_have_lock (c);
+  struct printf_buf *pb = pb_;
+
+  pb->char_cnt++;
+  pb->buf[pb->len++] = c;
+  if (pb->len >= sizeof pb->buf)
+    {
+      putbuf_have_lock (pb->buf, pb->len);
+      pb->len = 0;
+    }
 }
 
-/* Writes C to the vga display and serial port.
+/* Writes the N characters in BUFFER to the vga display and
+   serial port.
    The caller has already acquired the console lock if
-   appropriate. */
+   appropriate.
+   The vga layer keeps interrupts off while it writes, so a
+   large buffer is passed on PRINTF_BUF_SIZE bytes at a time. */
 static void
-putchar_have_lock (uint8_t c) 
+putbuf_have_lock (const char *buffer, size_t n) 
 {
   ASSERT (console_locked_by_current_thread ());
-  write_cnt++;
-  serial_putc (c);
-  vga_putc (c);
+  write_cnt += n;
+  while (n > 0)
+    {
+      size_t chunk = n < PRINTF_BUF_SIZE ? n : PRINTF_BUF_SIZE;
+      serial_putbuf ((const uint8_t *) buffer, chunk);
+      vga_putbuf (buffer, chunk);
+      buffer += chunk;
+      n -= chunk;
+    }
 }
@@ -0,0 +1,499 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include <stdint.h>
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Smallest number of slots in a table. */
+#define MIN_SLOTS 8
+
+/* Load limits, as numerators over 8.  A table grows when an
+   insertion would fill it beyond MAX_LOAD, and shrinks when a
+   deletion leaves it below MIN_LOAD. */
+#define MAX_LOAD 7
+#define MIN_LOAD 1
+
+/* Number of slots of the old table examined per insertion or
+   deletion while a resize is in progress.  Whole runs of
+   occupied slots are moved at once, so more may be moved. */
+#define MOVE_SLOTS 8
+
+static bool init_table (struct ohash_table *, size_t slot_cnt);
+static size_t find_slot (struct ohash *, struct ohash_table *, unsigned hash,
+                         struct hash_elem *);
+static void insert_slot (struct ohash_table *, struct ohash_slot);
+static void remove_slot (struct ohash_table *, size_t idx);
+static void move_some (struct ohash *, size_t slot_cnt);
+static void resize (struct ohash *);
+
+/* Returned by find_slot() if no slot matches. */
+#define NO_SLOT ((size_t) -1)
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using LESS, given auxiliary data AUX. */
+bool
+ohash_init (struct ohash *h,
+            hash_hash_func *hash, hash_less_func *less, void *aux)
+{
+  h->old.slot_cnt = h->old.elem_cnt = 0;
+  h->old.slots = NULL;
+  h->move_idx = h->move_left = 0;
+  h->hash = hash;
+  h->less = less;
+  h->aux = aux;
+  return init_table (&h->cur, MIN_SLOTS);
+}
+
+/* Calls DESTRUCTOR, if non-null, for each element in table T,
+   and empties T. */
+static void
+clear_table (struct ohash *h, struct ohash_table *t,
+             hash_action_func *destructor)
+{
+  size_t i;
+
+  for (i = 0; i < t->slot_cnt; i++)
+    if (t->slots[i].elem != NULL)
+      {
+        if (destructor != NULL)
+          destructor (t->slots[i].elem, h->aux);
+        t->slots[i].elem = NULL;
+      }
+  t->elem_cnt = 0;
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere. */
+void
+ohash_clear (struct ohash *h, hash_action_func *destructor)
+{
+  clear_table (h, &h->cur, destructor);
+  clear_table (h, &h->old, destructor);
+  free (h->old.slots);
+  h->old.slots = NULL;
+  h->old.slot_cnt = 0;
+  h->move_left = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, as for ohash_clear(). */
+void
+ohash_destroy (struct ohash *h, hash_action_func *destructor)
+{
+  if (destructor != NULL)
+    ohash_clear (h, destructor);
+  free (h->cur.slots);
+  free (h->old.slots);
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW. */
+struct hash_elem *
+ohash_insert (struct ohash *h, struct hash_elem *new)
+{
+  struct hash_elem *old = ohash_find (h, new);
+
+  if (old == NULL)
+    {
+      struct ohash_slot s;
+
+      s.hash = h->hash (new, h->aux);
+      s.elem = new;
+      move_some (h, MOVE_SLOTS);
+      resize (h);
+      insert_slot (&h->cur, s);
+    }
+  return old;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned. */
+struct hash_elem *
+ohash_replace (struct ohash *h, struct hash_elem *new)
+{
+  unsigned hash = h->hash (new, h->aux);
+  struct ohash_table *t = &h->cur;
+  size_t idx = find_slot (h, t, hash, new);
+
+  if (idx == NO_SLOT)
+    {
+      t = &h->old;
+      idx = find_slot (h, t, hash, new);
+    }
+  if (idx != NO_SLOT)
+    {
+      /* Equal elements have equal hashes, so NEW can simply take
+         the old element's slot. */
+      struct hash_elem *old = t->slots[idx].elem;
+      t->slots[idx].elem = new;
+      return old;
+    }
+
+  ohash_insert (h, new);
+  return NULL;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table. */
+struct hash_elem *
+ohash_find (struct ohash *h, struct hash_elem *e)
+{
+  unsigned hash = h->hash (e, h->aux);
+  size_t idx;
+
+  idx = find_slot (h, &h->cur, hash, e);
+  if (idx != NO_SLOT)
+    return h->cur.slots[idx].elem;
+  idx = find_slot (h, &h->old, hash, e);
+  if (idx != NO_SLOT)
+    return h->old.slots[idx].elem;
+  return NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct hash_elem *
+ohash_delete (struct ohash *h, struct hash_elem *e)
+{
+  unsigned hash = h->hash (e, h->aux);
+  struct ohash_table *t = &h->cur;
+  struct hash_elem *found;
+  size_t idx;
+
+  idx = find_slot (h, t, hash, e);
+  if (idx == NO_SLOT)
+    {
+      t = &h->old;
+      idx = find_slot (h, t, hash, e);
+      if (idx == NO_SLOT)
+        return NULL;
+    }
+
+  found = t->slots[idx].elem;
+  remove_slot (t, idx);
+  move_some (h, MOVE_SLOTS);
+  resize (h);
+  return found;
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, hash_action_func *action)
+{
+  struct ohash_iterator i;
+
+  ASSERT (action != NULL);
+
+  ohash_first (&i, h);
+  while (ohash_next (&i))
+    action (ohash_cur (&i), h->aux);
+}
+
+/* Initializes I for iterating hash table H.  The iteration idiom
+   is the same as for hash_first().
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h)
+{
+  ASSERT (i != NULL);
+  ASSERT (h != NULL);
+
+  i->hash = h;
+  i->idx = (size_t) -1;
+  i->elem = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order. */
+struct hash_elem *
+ohash_next (struct ohash_iterator *i)
+{
+  struct ohash *h;
+
+  ASSERT (i != NULL);
+
+  h = i->hash;
+  i->elem = NULL;
+  while (++i->idx < h->cur.slot_cnt + h->old.slot_cnt)
+    {
+      size_t idx = i->idx;
+      struct ohash_slot *s = (idx < h->cur.slot_cnt
+                              ? &h->cur.slots[idx]
+                              : &h->old.slots[idx - h->cur.slot_cnt]);
+      if (s->elem != NULL)
+        {
+          i->elem = s->elem;
+          break;
+        }
+    }
+  return i->elem;
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct hash_elem *
+ohash_cur (struct ohash_iterator *i)
+{
+  return i->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h)
+{
+  return h->cur.elem_cnt + h->old.elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h)
+{
+  return ohash_size (h) == 0;
+}
+
+/* Initializes T as an empty table with SLOT_CNT slots, which
+   must be a power of 2.  Returns true if successful, false if
+   memory could not be allocated. */
+static bool
+init_table (struct ohash_table *t, size_t slot_cnt)
+{
+  size_t i;
+
+  t->slots = malloc (sizeof *t->slots * slot_cnt);
+  if (t->slots == NULL)
+    return false;
+  t->slot_cnt = slot_cnt;
+  t->elem_cnt = 0;
+  for (i = 0; i < slot_cnt; i++)
+    t->slots[i].elem = NULL;
+  return true;
+}
+
+/* Returns the home slot of hash value HASH in T. */
+static inline size_t
+home_slot (const struct ohash_table *t, unsigned hash)
+{
+  return hash & (t->slot_cnt - 1);
+}
+
+/* Returns how far slot IDX in T is from the home slot of the
+   element it holds. */
+static inline size_t
+probe_dist (const struct ohash_table *t, size_t idx)
+{
+  return (idx - home_slot (t, t->slots[idx].hash)) & (t->slot_cnt - 1);
+}
+
+/* Returns the index of the slot in T that holds an element equal
+   to E, whose hash value is HASH, or NO_SLOT if there is none. */
+static size_t
+find_slot (struct ohash *h, struct ohash_table *t, unsigned hash,
+           struct hash_elem *e)
+{
+  size_t idx, dist;
+
+  if (t->elem_cnt == 0)
+    return NO_SLOT;
+
+  /* By the Robin Hood invariant, once we reach a slot whose
+     element is closer to its home than we are to ours, E cannot
+     be further along. */
+  idx = home_slot (t, hash);
+  for (dist = 0; dist < t->slot_cnt; dist++)
+    {
+      struct ohash_slot *s = &t->slots[idx];
+      if (s->elem == NULL || probe_dist (t, idx) < dist)
+        break;
+      if (s->hash == hash
+          && !h->less (s->elem, e, h->aux) && !h->less (e, s->elem, h->aux))
+        return idx;
+      idx = (idx + 1) & (t->slot_cnt - 1);
+    }
+  return NO_SLOT;
+}
+
+/* Inserts S into T, which must have an empty slot and must not
+   already contain an element equal to S's. */
+static void
+insert_slot (struct ohash_table *t, struct ohash_slot s)
+{
+  size_t idx = home_slot (t, s.hash);
+  size_t dist = 0;
+
+  ASSERT (t->elem_cnt < t->slot_cnt);
+
+  t->elem_cnt++;
+  for (;;)
+    {
+      struct ohash_slot *cur = &t->slots[idx];
+      size_t cur_dist;
+
+      if (cur->elem == NULL)
+        {
+          *cur = s;
+          return;
+        }
+
+      /* Take from the rich: the element that is nearer its home
+         gives up its slot and continues probing. */
+      cur_dist = probe_dist (t, idx);
+      if (cur_dist < dist)
+        {
+          struct ohash_slot tmp = *cur;
+          *cur = s;
+          s = tmp;
+          dist = cur_dist;
+        }
+      idx = (idx + 1) & (t->slot_cnt - 1);
+      dist++;
+    }
+}
+
+/* Removes the element in slot IDX of T, shifting the following
+   elements of its probe sequence back by one slot. */
+static void
+remove_slot (struct ohash_table *t, size_t idx)
+{
+  size_t next;
+
+  t->elem_cnt--;
+  for (;;)
+    {
+      next = (idx + 1) & (t->slot_cnt - 1);
+      if (t->slots[next].elem == NULL || probe_dist (t, next) == 0)
+        break;
+      t->slots[idx] = t->slots[next];
+      idx = next;
+    }
+  t->slots[idx].elem = NULL;
+}
+
+/* Moves the elements in the next SLOT_CNT or so slots of H's old
+   table into its current table, freeing the old table once it is
+   empty. */
+static void
+move_some (struct ohash *h, size_t slot_cnt)
+{
+  struct ohash_table *old = &h->old;
+
+  if (old->slots == NULL)
+    return;
+
+  /* Moving starts at an empty slot, and each run of occupied
+     slots is moved as a whole, so between calls the old table
+     consists of intact probe sequences and can still be
+     searched. */
+  while (h->move_left > 0)
+    {
+      struct ohash_slot *s = &old->slots[h->move_idx];
+
+      if (s->elem != NULL)
+        {
+          insert_slot (&h->cur, *s);
+          s->elem = NULL;
+          old->elem_cnt--;
+        }
+      else if (slot_cnt == 0)
+        break;
+
+      if (slot_cnt > 0)
+        slot_cnt--;
+      h->move_idx = (h->move_idx + 1) & (old->slot_cnt - 1);
+      h->move_left--;
+    }
+
+  if (h->move_left == 0)
+    {
+      ASSERT (old->elem_cnt == 0);
+      free (old->slots);
+      old->slots = NULL;
+      old->slot_cnt = 0;
+    }
+}
+
+/* Starts moving H's elements into a table of a better size, if
+   its current table is too full or too empty.  This function can
+   fail because of an out-of-memory condition, but that'll just
+   make hash accesses less efficient; we can still continue,
+   unless the table is completely full. */
+static void
+resize (struct ohash *h)
+{
+  size_t elem_cnt = ohash_size (h);
+  size_t slot_cnt = h->cur.slot_cnt;
+  size_t new_slot_cnt;
+  size_t i;
+
+  /* Leave room for one more element. */
+  if ((elem_cnt + 1) * 8 > slot_cnt * MAX_LOAD)
+    new_slot_cnt = slot_cnt * 2;
+  else if (elem_cnt * 8 < slot_cnt * MIN_LOAD && slot_cnt > MIN_SLOTS)
+    new_slot_cnt = slot_cnt / 2;
+  else
+    return;
+
+  /* Finish any move already in progress. */
+  move_some (h, SIZE_MAX);
+
+  h->old = h->cur;
+  if (!init_table (&h->cur, new_slot_cnt))
+    {
+      h->cur = h->old;
+      h->old.slots = NULL;
+      h->old.slot_cnt = h->old.elem_cnt = 0;
+      if (h->cur.elem_cnt >= h->cur.slot_cnt)
+        PANIC ("ohash: table full and out of memory");
+      return;
+    }
+
+  /* Start moving at an empty slot. */
+  for (i = 0; i < h->old.slot_cnt; i++)
+    if (h->old.slots[i].elem == NULL)
+      break;
+  if (i < h->old.slot_cnt)
+    {
+      h->move_idx = i;
+      h->move_left = h->old.slot_cnt;
+    }
+  else
+    {
+      /* Completely full, so there are no whole runs to move:
+         move everything now. */
+      for (i = 0; i < h->old.slot_cnt; i++)
+        insert_slot (&h->cur, h->old.slots[i]);
+      free (h->old.slots);
+      h->old.slots = NULL;
+      h->old.slot_cnt = h->old.elem_cnt = 0;
+      h->move_left = 0;
+    }
+}
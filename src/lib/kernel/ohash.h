@@ -0,0 +1,93 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+
+   An alternative to the chained hash table in hash.h, with the
+   same interface and the same element contract: each structure
+   that can be in an ohash embeds a struct hash_elem, and the
+   table is keyed by hash_hash_func and hash_less_func exactly as
+   for a struct hash.  The two tables may be swapped for one
+   another by changing only the type of the table and the names
+   of the functions called.
+
+   Instead of a list per bucket, the table is a single array of
+   slots, each holding an element pointer and that element's hash
+   value.  A lookup probes consecutive slots and compares the
+   stored hash before calling the comparison function, so it
+   rarely touches an element that does not match.  Insertion uses
+   Robin Hood hashing: an element that has probed further from
+   its home slot takes the place of one that has probed less,
+   which keeps probe sequences short even at high load, and lets
+   an unsuccessful lookup stop early.  Deletion shifts the rest
+   of the probe sequence back by one, so no tombstones are left.
+
+   When the table grows or shrinks, the elements are not all
+   moved at once.  The new array is allocated and the old one is
+   kept; each later insertion or deletion moves a few of the old
+   array's slots across, and lookups search both arrays until the
+   move is complete.  Thus no single operation pays for
+   rehashing the whole table. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/* A slot in an open-addressing table. */
+struct ohash_slot
+  {
+    unsigned hash;              /* Hash value of `elem'. */
+    struct hash_elem *elem;     /* Element, or a null pointer if empty. */
+  };
+
+/* An array of slots. */
+struct ohash_table
+  {
+    size_t slot_cnt;            /* Number of slots, a power of 2, or 0. */
+    size_t elem_cnt;            /* Number of elements in slots. */
+    struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+  };
+
+/* Open-addressing hash table. */
+struct ohash
+  {
+    struct ohash_table cur;     /* Table that receives insertions. */
+    struct ohash_table old;     /* Table being moved into `cur'. */
+    size_t move_idx;            /* Next slot of `old' to move. */
+    size_t move_left;           /* Slots of `old' left to move. */
+    hash_hash_func *hash;       /* Hash function. */
+    hash_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `hash' and `less'. */
+  };
+
+/* An open-addressing hash table iterator. */
+struct ohash_iterator
+  {
+    struct ohash *hash;         /* The hash table. */
+    size_t idx;                 /* Slot index, counting `cur' then `old'. */
+    struct hash_elem *elem;     /* Current hash element. */
+  };
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, hash_hash_func *, hash_less_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, hash_action_func *);
+void ohash_destroy (struct ohash *, hash_action_func *);
+
+/* Search, insertion, deletion. */
+struct hash_elem *ohash_insert (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_replace (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_find (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_delete (struct ohash *, struct hash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, hash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct hash_elem *ohash_next (struct ohash_iterator *);
+struct hash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -28,7 +28,17 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_SBRK,                   /* Grow or shrink the heap. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write to a file from several buffers. */
+    SYS_PREAD,                  /* Read from a file at a given position. */
+    SYS_PWRITE,                 /* Write to a file at a given position. */
+    SYS_COPY_RANGE,             /* Copy data from one file to another. */
+    SYS_RING_SUBMIT,            /* Run the calls queued in a ring. */
+    SYS_SYSENTER                /* Check whether SYSENTER may be used. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,42 @@
+#ifndef __LIB_SYSRING_H
+#define __LIB_SYSRING_H
+
+/* System call ring.
+
+   A user program may queue several system calls in a ring in its
+   own memory and have the kernel carry them all out with a
+   single trap, instead of trapping once per call.
+
+   The program fills in the entry at index HEAD (modulo
+   SYS_RING_SIZE) and advances HEAD, for each call it queues.
+   The SYS_RING_SUBMIT system call then carries out the calls
+   from TAIL up to HEAD in order, storing each one's return value
+   in its entry and advancing TAIL past it.  Entries before TAIL
+   are complete and may be reused once the program has read
+   their results.
+
+   Only calls that do not create or end processes may be queued;
+   see syscall.c in the kernel for the list.  An entry with any
+   other call completes with result -1. */
+
+/* Number of entries in a ring.  Must be a power of 2. */
+#define SYS_RING_SIZE 64
+
+/* One queued system call. */
+struct sys_op
+  {
+    int call_nr;                /* System call number, SYS_*. */
+    int args[4];                /* Arguments. */
+    int result;                 /* Return value, once complete. */
+  };
+
+/* A system call ring. */
+struct sys_ring
+  {
+    unsigned head;              /* Next entry to queue.  Set by user. */
+    unsigned tail;              /* Next entry to run.  Set by kernel. */
+    unsigned reaped;            /* Next result to read.  User only. */
+    struct sys_op ops[SYS_RING_SIZE];   /* Entries. */
+  };
+
+#endif /* lib/sysring.h */
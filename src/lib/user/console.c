@@ -3,6 +3,98 @@
 #include <syscall.h>
 #include <syscall-nr.h>
 
+/* Console output buffer.
+
+   Output to STDOUT_FILENO from printf(), putchar(), and puts()
+   is collected here and written to the console with a single
+   write() system call per line, or per buffer full, depending
+   on the buffering mode chosen with setvbuf().  fflush() writes
+   out whatever is buffered, and so do write() to STDOUT_FILENO,
+   read() from STDIN_FILENO, and exit(), so that output appears
+   in order and before the program waits for input or exits. */
+static char default_buf[BUFSIZ];        /* Buffer used by default. */
+static char *out_buf = default_buf;     /* Buffer. */
+static size_t out_size = BUFSIZ;        /* Size of buffer. */
+static size_t out_len;                  /* Bytes now in buffer. */
+static int out_mode = _IOLBF;           /* Buffering mode. */
+
+/* Sets the buffering MODE for HANDLE, which must be
+   STDOUT_FILENO, to one of _IONBF, _IOLBF, or _IOFBF.  If BUF
+   is nonnull, it will be used as the buffer, which is SIZE
+   bytes long; otherwise, a built-in buffer of BUFSIZ bytes is
+   used.  Returns 0 if successful, -1 on failure. */
+int
+setvbuf (int handle, char *buf, int mode, size_t size) 
+{
+  if (handle != STDOUT_FILENO
+      || (mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
+      || (buf != NULL && size == 0))
+    return -1;
+
+  fflush (handle);
+  out_buf = buf != NULL ? buf : default_buf;
+  out_size = buf != NULL ? size : BUFSIZ;
+  out_mode = mode;
+  return 0;
+}
+
+/* Writes out any output buffered for HANDLE.
+   Returns 0 if successful, -1 on failure. */
+int
+fflush (int handle) 
+{
+  size_t len = out_len;
+
+  if (handle != STDOUT_FILENO)
+    return 0;
+
+  /* Empty the buffer before calling write(), which flushes the
+     buffer itself. */
+  out_len = 0;
+  if (len > 0 && write (STDOUT_FILENO, out_buf, len) != (int) len)
+    return -1;
+  return 0;
+}
+
+/* Appends the SIZE bytes in BUFFER to the console output
+   buffer, writing out the buffer as it fills up. */
+static void
+buffer_output (const char *buffer, size_t size) 
+{
+  while (size > 0)
+    {
+      size_t chunk;
+
+      if (out_len == 0 && size >= out_size)
+        {
+          /* Too big to be worth buffering. */
+          write (STDOUT_FILENO, buffer, size);
+          return;
+        }
+
+      chunk = out_size - out_len;
+      if (chunk > size)
+        chunk = size;
+      memcpy (out_buf + out_len, buffer, chunk);
+      out_len += chunk;
+      buffer += chunk;
+      size -= chunk;
+
+      if (out_len == out_size)
+        fflush (STDOUT_FILENO);
+    }
+}
+
+/* Writes out buffered console output as the buffering mode
+   requires, at the end of a call that output NEWLINE_CNT new-line
+   characters. */
+static void
+end_output (int newline_cnt) 
+{
+  if (out_mode == _IONBF || (out_mode == _IOLBF && newline_cnt > 0))
+    fflush (STDOUT_FILENO);
+}
+
 /* The standard vprintf() function,
    which is like printf() but uses a va_list. */
 int
@@ -30,8 +122,9 @@ hprintf (int handle, const char *format, ...)
 int
 puts (const char *s) 
 {
-  write (STDOUT_FILENO, s, strlen (s));
-  putchar ('\n');
+  buffer_output (s, strlen (s));
+  buffer_output ("\n", 1);
+  end_output (1);
 
   return 0;
 }
@@ -41,7 +134,8 @@ int
 putchar (int c) 
 {
   char c2 = c;
-  write (STDOUT_FILENO, &c2, 1);
+  buffer_output (&c2, 1);
+  end_output (c2 == '\n');
   return c;
 }
 
@@ -51,6 +145,7 @@ struct vhprintf_aux
     char buf[64];       /* Character buffer. */
     char *p;            /* Current position in buffer. */
     int char_cnt;       /* Total characters written so far. */
+    int newline_cnt;    /* New-line characters written so far. */
     int handle;         /* Output file handle. */
   };
 
@@ -66,9 +161,12 @@ vhprintf (int handle, const char *format, va_list args)
   struct vhprintf_aux aux;
   aux.p = aux.buf;
   aux.char_cnt = 0;
+  aux.newline_cnt = 0;
   aux.handle = handle;
   __vprintf (format, args, add_char, &aux);
   flush (&aux);
+  if (handle == STDOUT_FILENO)
+    end_output (aux.newline_cnt);
   return aux.char_cnt;
 }
 
@@ -82,13 +180,21 @@ add_char (char c, void *aux_)
   if (aux->p >= aux->buf + sizeof aux->buf)
     flush (aux);
   aux->char_cnt++;
+  if (c == '\n')
+    aux->newline_cnt++;
 }
 
-/* Flushes the buffer in AUX. */
+/* Flushes the buffer in AUX, into the console output buffer if
+   AUX is writing to the console. */
 static void
 flush (struct vhprintf_aux *aux)
 {
   if (aux->p > aux->buf)
-    write (aux->handle, aux->buf, aux->p - aux->buf);
+    {
+      if (aux->handle == STDOUT_FILENO)
+        buffer_output (aux->buf, aux->p - aux->buf);
+      else
+        write (aux->handle, aux->buf, aux->p - aux->buf);
+    }
   aux->p = aux->buf;
 }
@@ -0,0 +1,16 @@
+#ifndef __LIB_USER_CPU_H
+#define __LIB_USER_CPU_H
+
+#include <stdint.h>
+
+/* Returns the processor's time-stamp counter, which counts CPU
+   cycles since reset.  RDTSC may be executed in user mode. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* lib/user/cpu.h */
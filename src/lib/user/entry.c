@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <syscall.h>
 
 int main (int, char *[]);
@@ -6,5 +7,12 @@ void _start (int argc, char *argv[]);
 void
 _start (int argc, char *argv[]) 
 {
-  exit (main (argc, argv));
+  int status;
+
+  syscall_use_sysenter (true);
+  status = main (argc, argv);
+
+  /* Write out buffered console output before exiting. */
+  fflush (STDOUT_FILENO);
+  exit (status);
 }
@@ -0,0 +1,372 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include <debug.h>
+#include <round.h>
+
+/* A simple implementation of malloc() for user programs.
+
+   The heap is a contiguous region obtained from the kernel with
+   sbrk().  It is divided into blocks, each of which begins with
+   a header word and ends with a footer word.  Both hold the
+   size of the block in bytes, including header and footer, with
+   the low bit set if the block is in use.  The footer lets
+   free() find the block before the one being freed, so that
+   adjacent free blocks can always be merged into one.
+
+   Block payloads are 8-byte aligned.  The heap begins with a
+   "prologue" block and ends with an "epilogue" header, both
+   marked in use, so that merging never runs off either end.
+
+   Free blocks are kept in doubly linked lists, one per
+   power-of-2 size class, with the links stored in the payload.
+   malloc() takes the first block that fits from the smallest
+   class that can satisfy the request, splitting off any
+   remainder large enough to be a block of its own.  When no
+   block fits, the heap is grown by at least HEAP_CHUNK bytes.
+
+   A program that uses malloc() must not also move the break
+   with sbrk() itself. */
+
+/* Block header or footer bits. */
+#define USED 1u                 /* Block is in use. */
+
+/* Alignment of payloads. */
+#define ALIGN 8
+
+/* Header and footer overhead per block. */
+#define OVERHEAD (2 * sizeof (uint32_t))
+
+/* Smallest block: header, two links, footer. */
+#define MIN_BLOCK 16
+
+/* Minimum amount to grow the heap by. */
+#define HEAP_CHUNK (64 * 1024)
+
+/* Number of size classes.  Class I holds free blocks of
+   2**(I+4) bytes up to but not including 2**(I+5) bytes, except
+   that the last class holds everything larger too. */
+#define BIN_CNT 20
+
+/* Links in a free block's payload. */
+struct free_block
+  {
+    struct free_block *prev;    /* Previous block in size class. */
+    struct free_block *next;    /* Next block in size class. */
+  };
+
+/* Free lists, one per size class. */
+static struct free_block *bins[BIN_CNT];
+
+/* True once the heap has been set up. */
+static bool heap_ready;
+
+/* Returns the header of the block whose payload is P. */
+static inline uint32_t *
+header (void *p)
+{
+  return (uint32_t *) p - 1;
+}
+
+/* Returns the size of the block whose payload is P. */
+static inline size_t
+block_size (void *p)
+{
+  return *header (p) & ~USED;
+}
+
+/* Returns true if the block whose payload is P is in use. */
+static inline bool
+block_used (void *p)
+{
+  return (*header (p) & USED) != 0;
+}
+
+/* Returns the footer of the block whose payload is P. */
+static inline uint32_t *
+footer (void *p)
+{
+  return (uint32_t *) ((uint8_t *) p + block_size (p) - OVERHEAD);
+}
+
+/* Sets the header and footer of the block whose payload is P to
+   SIZE and the USED bit given by USED_BIT. */
+static inline void
+set_block (void *p, size_t size, uint32_t used_bit)
+{
+  *header (p) = size | used_bit;
+  *footer (p) = size | used_bit;
+}
+
+/* Returns the payload of the block after the one at P. */
+static inline void *
+next_block (void *p)
+{
+  return (uint8_t *) p + block_size (p);
+}
+
+/* Returns the payload of the block before the one at P. */
+static inline void *
+prev_block (void *p)
+{
+  uint32_t prev_footer = *((uint32_t *) p - 2);
+  return (uint8_t *) p - (prev_footer & ~USED);
+}
+
+/* Returns the size class for a block of SIZE bytes. */
+static size_t
+bin_index (size_t size)
+{
+  size_t idx = 0;
+  for (size >>= 5; size > 0 && idx < BIN_CNT - 1; size >>= 1)
+    idx++;
+  return idx;
+}
+
+/* Adds free block P to its size class. */
+static void
+bin_insert (void *p)
+{
+  struct free_block *b = p;
+  size_t idx = bin_index (block_size (p));
+
+  b->prev = NULL;
+  b->next = bins[idx];
+  if (b->next != NULL)
+    b->next->prev = b;
+  bins[idx] = b;
+}
+
+/* Removes free block P from its size class. */
+static void
+bin_remove (void *p)
+{
+  struct free_block *b = p;
+
+  if (b->prev != NULL)
+    b->prev->next = b->next;
+  else
+    bins[bin_index (block_size (p))] = b->next;
+  if (b->next != NULL)
+    b->next->prev = b->prev;
+}
+
+/* Merges free block P, which is not in any size class, with its
+   free neighbors, removing them from their size classes, and
+   returns the merged block, which is not in any size class. */
+static void *
+coalesce (void *p)
+{
+  size_t size = block_size (p);
+  void *next = next_block (p);
+
+  if (!block_used (next))
+    {
+      bin_remove (next);
+      size += block_size (next);
+    }
+  if (!block_used (prev_block (p)))
+    {
+      p = prev_block (p);
+      bin_remove (p);
+      size += block_size (p);
+    }
+  set_block (p, size, 0);
+  return p;
+}
+
+/* Sets up the heap: an unused word, the prologue block, and the
+   epilogue header, aligned so that the payload of the first
+   block added by heap_grow() is aligned.
+   Returns true if successful, false on failure. */
+static bool
+heap_init (void)
+{
+  uint8_t *base = sbrk (0);
+  size_t pad = ROUND_UP ((uintptr_t) base, ALIGN) - (uintptr_t) base;
+  uint8_t *prologue;
+
+  if (sbrk (pad + 4 * sizeof (uint32_t)) == (void *) -1)
+    return false;
+
+  prologue = base + pad + 2 * sizeof (uint32_t);
+  set_block (prologue, OVERHEAD, USED);
+  *header (next_block (prologue)) = 0 | USED;
+  heap_ready = true;
+  return true;
+}
+
+/* Grows the heap by at least SIZE bytes and returns the payload
+   of the free block that results, merged with any free block
+   before it and not in any size class, or a null pointer if the
+   kernel refuses. */
+static void *
+heap_grow (size_t size)
+{
+  void *p;
+
+  if (size < HEAP_CHUNK)
+    size = HEAP_CHUNK;
+  p = sbrk (size);
+  if (p == (void *) -1)
+    return NULL;
+
+  /* The old epilogue header becomes the new block's header. */
+  set_block (p, size, 0);
+  *header (next_block (p)) = 0 | USED;
+  return coalesce (p);
+}
+
+/* Marks free block P, not in any size class, as in use with
+   SIZE bytes, returning any remainder large enough to be a block
+   of its own to the free lists. */
+static void
+place (void *p, size_t size)
+{
+  size_t avail = block_size (p);
+
+  if (avail - size >= MIN_BLOCK)
+    {
+      void *rest;
+      set_block (p, size, USED);
+      rest = next_block (p);
+      set_block (rest, avail - size, 0);
+      bin_insert (coalesce (rest));
+    }
+  else
+    set_block (p, avail, USED);
+}
+
+/* Returns the block size needed for a payload of SIZE bytes, or
+   0 if SIZE is too large. */
+static size_t
+request_size (size_t size)
+{
+  if (size > SIZE_MAX / 2)
+    return 0;
+  size = ROUND_UP (size + OVERHEAD, ALIGN);
+  return size < MIN_BLOCK ? MIN_BLOCK : size;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size)
+{
+  size_t need = request_size (size);
+  size_t idx;
+  void *p;
+
+  if (size == 0 || need == 0)
+    return NULL;
+  if (!heap_ready && !heap_init ())
+    return NULL;
+
+  /* First fit, starting from NEED's own size class. */
+  for (idx = bin_index (need); idx < BIN_CNT; idx++)
+    {
+      struct free_block *b;
+      for (b = bins[idx]; b != NULL; b = b->next)
+        if (block_size (b) >= need)
+          {
+            bin_remove (b);
+            place (b, need);
+            return b;
+          }
+    }
+
+  p = heap_grow (need);
+  if (p == NULL)
+    return NULL;
+  place (p, need);
+  return p;
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b)
+{
+  void *p;
+  size_t size;
+
+  /* Calculate block size and make sure it fits in size_t. */
+  size = a * b;
+  if (size < a || size < b)
+    return NULL;
+
+  /* Allocate and zero memory. */
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+
+  return p;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size)
+{
+  size_t need, have;
+  void *new_block;
+
+  if (new_size == 0)
+    {
+      free (old_block);
+      return NULL;
+    }
+  if (old_block == NULL)
+    return malloc (new_size);
+
+  need = request_size (new_size);
+  if (need == 0)
+    return NULL;
+  have = block_size (old_block);
+
+  /* Grow in place into a free block that follows. */
+  if (need > have)
+    {
+      void *next = next_block (old_block);
+      if (!block_used (next) && have + block_size (next) >= need)
+        {
+          bin_remove (next);
+          have += block_size (next);
+          set_block (old_block, have, 0);
+        }
+    }
+
+  /* Fits in place, possibly after growing. */
+  if (need <= have)
+    {
+      place (old_block, need);
+      return old_block;
+    }
+
+  /* Move. */
+  new_block = malloc (new_size);
+  if (new_block != NULL)
+    {
+      memcpy (new_block, old_block, have - OVERHEAD);
+      free (old_block);
+    }
+  return new_block;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p)
+{
+  if (p == NULL)
+    return;
+
+  ASSERT (block_used (p));
+  set_block (p, block_size (p), 0);
+  bin_insert (coalesce (p));
+}
@@ -4,4 +4,15 @@
 int hprintf (int, const char *, ...) PRINTF_FORMAT (2, 3);
 int vhprintf (int, const char *, va_list) PRINTF_FORMAT (2, 0);
 
+/* Console output buffering modes, for setvbuf(). */
+#define _IONBF 0        /* Write out each call's output at once. */
+#define _IOLBF 1        /* Write out complete lines (the default). */
+#define _IOFBF 2        /* Write out only when the buffer fills. */
+
+/* Default console output buffer size. */
+#define BUFSIZ 512
+
+int setvbuf (int handle, char *buf, int mode, size_t size);
+int fflush (int handle);
+
 #endif /* lib/user/stdio.h */
@@ -1,9 +1,14 @@
 #include <syscall.h>
+#include <stdio.h>
 #include "../syscall-nr.h"
 
-/* Invokes syscall NUMBER, passing no arguments, and returns the
-   return value as an `int'. */
-#define syscall0(NUMBER)                                        \
+/* True to enter the kernel with SYSENTER, false to use
+   "int $0x30".  See syscall_use_sysenter(). */
+static bool sysenter_on;
+
+/* Invokes syscall NUMBER with "int $0x30", passing no
+   arguments, and returns the return value as an `int'. */
+#define int_syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -16,7 +21,7 @@
 
 /* Invokes syscall NUMBER, passing argument ARG0, and returns the
    return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
+#define int_syscall1(NUMBER, ARG0)                                           \
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
@@ -30,7 +35,7 @@
 
 /* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
    returns the return value as an `int'. */
-#define syscall2(NUMBER, ARG0, ARG1)                            \
+#define int_syscall2(NUMBER, ARG0, ARG1)                            \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -46,7 +51,7 @@
 
 /* Invokes syscall NUMBER, passing arguments ARG0, ARG1, and
    ARG2, and returns the return value as an `int'. */
-#define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
+#define int_syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -61,9 +66,79 @@
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define int_syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; pushl %[number]; int $0x30; "      \
+             "addl $20, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2),                             \
+                 [arg3] "r" (ARG3)                              \
+               : "memory");                                     \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER with SYSENTER, passing arguments ARG0,
+   ARG1, ARG2, and ARG3 in EBX, ESI, EDI, and EBP, and returns
+   the return value as an `int'.  The kernel returns with SYSEXIT
+   to the address in EDX with the stack pointer in ECX, and
+   preserves EBX, ESI, EDI, and EBP.  EBP may be the frame
+   pointer, so it is saved on the stack around the call. */
+#define sysenter_syscall(NUMBER, ARG0, ARG1, ARG2, ARG3)        \
+        ({                                                      \
+          int retval, ecx;                                      \
+          asm volatile                                          \
+            ("pushl %%ebp; movl %%ecx, %%ebp; "                 \
+             "movl %%esp, %%ecx; movl $1f, %%edx; "             \
+             "sysenter; 1: popl %%ebp"                          \
+               : "=a" (retval), "=c" (ecx)                      \
+               : "0" (NUMBER),                                  \
+                 "b" (ARG0),                                    \
+                 "S" (ARG1),                                    \
+                 "D" (ARG2),                                    \
+                 "1" (ARG3)                                     \
+               : "edx", "memory", "cc");                        \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER, passing up to 4 arguments, by the
+   fastest means the kernel allows, and returns the return value
+   as an `int'. */
+#define syscall0(NUMBER)                                        \
+        (sysenter_on                                            \
+         ? sysenter_syscall (NUMBER, 0, 0, 0, 0)                \
+         : int_syscall0 (NUMBER))
+#define syscall1(NUMBER, ARG0)                                  \
+        (sysenter_on                                            \
+         ? sysenter_syscall (NUMBER, (int) (ARG0), 0, 0, 0)     \
+         : int_syscall1 (NUMBER, ARG0))
+#define syscall2(NUMBER, ARG0, ARG1)                            \
+        (sysenter_on                                            \
+         ? sysenter_syscall (NUMBER, (int) (ARG0),              \
+                             (int) (ARG1), 0, 0)                \
+         : int_syscall2 (NUMBER, ARG0, ARG1))
+#define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
+        (sysenter_on                                            \
+         ? sysenter_syscall (NUMBER, (int) (ARG0),              \
+                             (int) (ARG1), (int) (ARG2), 0)     \
+         : int_syscall3 (NUMBER, ARG0, ARG1, ARG2))
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        (sysenter_on                                            \
+         ? sysenter_syscall (NUMBER, (int) (ARG0), (int) (ARG1),\
+                             (int) (ARG2), (int) (ARG3))        \
+         : int_syscall4 (NUMBER, ARG0, ARG1, ARG2, ARG3))
+
 void
 halt (void) 
 {
+  fflush (STDOUT_FILENO);
   syscall0 (SYS_HALT);
   NOT_REACHED ();
 }
@@ -71,6 +146,7 @@ halt (void)
 void
 exit (int status)
 {
+  fflush (STDOUT_FILENO);
   syscall1 (SYS_EXIT, status);
   NOT_REACHED ();
 }
@@ -114,12 +190,16 @@ filesize (int fd)
 int
 read (int fd, void *buffer, unsigned size)
 {
+  if (fd == STDIN_FILENO)
+    fflush (STDOUT_FILENO);
   return syscall3 (SYS_READ, fd, buffer, size);
 }
 
 int
 write (int fd, const void *buffer, unsigned size)
 {
+  if (fd == STDOUT_FILENO)
+    fflush (STDOUT_FILENO);
   return syscall3 (SYS_WRITE, fd, buffer, size);
 }
 
@@ -182,3 +262,114 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+void *
+sbrk (intptr_t increment) 
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) 
+{
+  if (fd == STDIN_FILENO)
+    fflush (STDOUT_FILENO);
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) 
+{
+  if (fd == STDOUT_FILENO)
+    fflush (STDOUT_FILENO);
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned position) 
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, position);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned position) 
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, position);
+}
+
+int
+copy_range (int in_fd, int out_fd, unsigned length) 
+{
+  return syscall3 (SYS_COPY_RANGE, in_fd, out_fd, length);
+}
+
+/* Initializes RING as empty. */
+void
+sys_ring_init (struct sys_ring *ring) 
+{
+  ring->head = ring->tail = ring->reaped = 0;
+}
+
+/* Queues system call CALL_NR with arguments ARG0 through ARG3 in
+   RING and returns its entry, or a null pointer if RING has no
+   free entry because results have not yet been reaped.  Unused
+   arguments are ignored.  The call is not made until
+   sys_ring_submit(). */
+struct sys_op *
+sys_ring_queue (struct sys_ring *ring, int call_nr,
+                int arg0, int arg1, int arg2, int arg3) 
+{
+  struct sys_op *op;
+
+  if (ring->head - ring->reaped >= SYS_RING_SIZE)
+    return NULL;
+  op = &ring->ops[ring->head & (SYS_RING_SIZE - 1)];
+  op->call_nr = call_nr;
+  op->args[0] = arg0;
+  op->args[1] = arg1;
+  op->args[2] = arg2;
+  op->args[3] = arg3;
+  op->result = -1;
+  ring->head++;
+  return op;
+}
+
+/* Has the kernel make every call queued in RING, with a single
+   trap.  Returns the number of calls made, or -1 if RING is
+   corrupt. */
+int
+sys_ring_submit (struct sys_ring *ring) 
+{
+  fflush (STDOUT_FILENO);
+  return syscall1 (SYS_RING_SUBMIT, ring);
+}
+
+/* Returns the oldest completed entry in RING whose result has
+   not yet been reaped, or a null pointer if there is none.  The
+   entry may be reused by a later sys_ring_queue(). */
+struct sys_op *
+sys_ring_reap (struct sys_ring *ring) 
+{
+  if (ring->reaped == ring->tail)
+    return NULL;
+  return &ring->ops[ring->reaped++ & (SYS_RING_SIZE - 1)];
+}
+
+/* Makes later system calls enter the kernel with SYSENTER if
+   ENABLE is true and the kernel allows it, or with "int $0x30"
+   otherwise.  Returns true if SYSENTER is now in use.  _start()
+   enables SYSENTER before calling main(). */
+bool
+syscall_use_sysenter (bool enable) 
+{
+  sysenter_on = enable && int_syscall0 (SYS_SYSENTER);
+  return sysenter_on;
+}
+
+/* Returns true if the kernel allows SYSENTER.  This call does
+   nothing else, so it also measures the cost of a system call. */
+bool
+sysenter_allowed (void) 
+{
+  return syscall0 (SYS_SYSENTER);
+}
@@ -2,7 +2,10 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <debug.h>
+#include <iovec.h>
+#include <sysring.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +48,24 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+void *sbrk (intptr_t increment);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned position);
+int pwrite (int fd, const void *buffer, unsigned length,
+            unsigned position);
+int copy_range (int in_fd, int out_fd, unsigned length);
+
+/* System call rings. */
+void sys_ring_init (struct sys_ring *);
+struct sys_op *sys_ring_queue (struct sys_ring *, int call_nr,
+                               int arg0, int arg1, int arg2, int arg3);
+int sys_ring_submit (struct sys_ring *);
+struct sys_op *sys_ring_reap (struct sys_ring *);
+
+/* System call entry. */
+bool syscall_use_sysenter (bool enable);
+bool sysenter_allowed (void);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,151 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Attempts to test the bitmap searching functionality that is
+   not sufficiently tested elsewhere in Pintos, by comparing
+   bitmap_scan(), bitmap_contains(), and the next-fit functions
+   against a simple bit-by-bit search on random bitmaps.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of bits in a bitmap that we will test. */
+#define MAX_BITS 300
+
+/* Maximum group size to search for. */
+#define MAX_CNT 12
+
+static void randomize (struct bitmap *, int density);
+static size_t slow_scan (const struct bitmap *, size_t start, size_t cnt,
+                         bool value);
+static void test_next_fit (size_t bit_cnt);
+
+/* Test the bitmap implementation. */
+void
+test (void) 
+{
+  size_t bit_cnt;
+
+  printf ("testing various size bitmaps:");
+  for (bit_cnt = 0; bit_cnt <= MAX_BITS; bit_cnt++) 
+    {
+      struct bitmap *b = bitmap_create (bit_cnt);
+      int repeat;
+
+      ASSERT (b != NULL);
+      if (bit_cnt % 25 == 0)
+        printf (" %zu", bit_cnt);
+      for (repeat = 0; repeat < 10; repeat++) 
+        {
+          size_t start, cnt;
+
+          /* Densities from all-clear to all-set. */
+          randomize (b, repeat);
+          for (start = 0; start <= bit_cnt; start++)
+            for (cnt = 0; cnt <= MAX_CNT; cnt++) 
+              {
+                ASSERT (bitmap_scan (b, start, cnt, false)
+                        == slow_scan (b, start, cnt, false));
+                ASSERT (bitmap_scan (b, start, cnt, true)
+                        == slow_scan (b, start, cnt, true));
+                if (start + cnt <= bit_cnt) 
+                  {
+                    size_t first = slow_scan (b, start, 1, true);
+                    ASSERT (bitmap_contains (b, start, cnt, true)
+                            == (cnt > 0 && first < start + cnt));
+                  }
+              }
+        }
+      bitmap_destroy (b);
+
+      test_next_fit (bit_cnt);
+    }
+
+  printf (" done\n");
+  printf ("bitmap: PASS\n");
+}
+
+/* Sets each bit in B with probability DENSITY / 9. */
+static void
+randomize (struct bitmap *b, int density) 
+{
+  size_t i;
+
+  for (i = 0; i < bitmap_size (b); i++)
+    bitmap_set (b, i, (int) (random_ulong () % 9) < density);
+}
+
+/* Returns the first group of CNT bits in B at or after START set
+   to VALUE, testing one bit at a time, or BITMAP_ERROR. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, j;
+
+  if (cnt == 0)
+    return start;
+  for (i = start; i + cnt <= bitmap_size (b); i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Allocates every bit of a BIT_CNT-bit bitmap one at a time with
+   the next-fit functions, checking that each comes from the
+   cursor position, then frees and reallocates bits at random and
+   checks that the search wraps around. */
+static void
+test_next_fit (size_t bit_cnt) 
+{
+  struct bitmap *b = bitmap_create (bit_cnt);
+  size_t cursor = 0;
+  size_t i;
+
+  ASSERT (b != NULL);
+
+  /* Fill in order. */
+  for (i = 0; i < bit_cnt; i++) 
+    {
+      ASSERT (bitmap_scan_and_flip_next_fit (b, &cursor, 1, false) == i);
+      ASSERT (cursor == i + 1);
+    }
+  ASSERT (bitmap_scan_next_fit (b, &cursor, 1, false) == BITMAP_ERROR);
+  ASSERT (cursor == bit_cnt);
+
+  /* Free random bits, then reallocate them.  Each search must
+     find the first free bit at or after the cursor, wrapping
+     around to the start if necessary. */
+  for (i = 0; i < bit_cnt; i++)
+    if (random_ulong () % 3 == 0)
+      bitmap_reset (b, i);
+  while (!bitmap_all (b, 0, bit_cnt)) 
+    {
+      size_t expected = slow_scan (b, cursor, 1, false);
+      if (expected == BITMAP_ERROR)
+        expected = slow_scan (b, 0, 1, false);
+      ASSERT (bitmap_scan_and_flip_next_fit (b, &cursor, 1, false)
+              == expected);
+      ASSERT (cursor == expected + 1);
+    }
+
+  /* Groups too large for the bitmap are never found. */
+  bitmap_set_all (b, false);
+  cursor = bit_cnt / 2;
+  ASSERT (bitmap_scan_next_fit (b, &cursor, bit_cnt + 1, false)
+          == BITMAP_ERROR);
+  ASSERT (cursor == bit_cnt / 2);
+
+  bitmap_destroy (b);
+}
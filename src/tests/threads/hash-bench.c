@@ -0,0 +1,262 @@
+/* Benchmark for lib/kernel/hash.c and lib/kernel/ohash.c.
+
+   Compares the chained and open-addressing hash tables on two
+   workloads shaped like their uses in Pintos: a supplemental
+   page table, keyed by user page address, and an open-file
+   table, keyed by small integer file descriptors.  For each, it
+   reports the average number of CPU cycles per insertion,
+   successful lookup, unsuccessful lookup, and deletion.  It also
+   checks that both tables agree on every result.
+
+   This is a benchmark, not a pass/fail test, so it is not part
+   of the graded test suite.  Run it with "run hash-bench". */
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <ohash.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/vaddr.h"
+
+/* Number of pages in the page table workload. */
+#define PAGE_CNT 2048
+
+/* Number of descriptors in the file table workload. */
+#define FD_CNT 64
+
+/* Times each element is looked up. */
+#define LOOKUP_ROUNDS 8
+
+/* A table element.  KEY is a user page address or a file
+   descriptor number. */
+struct value
+  {
+    struct hash_elem elem;
+    uintptr_t key;
+  };
+
+static unsigned page_hash (const struct hash_elem *, void *);
+static unsigned fd_hash (const struct hash_elem *, void *);
+static bool value_less (const struct hash_elem *, const struct hash_elem *,
+                        void *);
+
+/* Operations on one kind of table, so that both kinds can be
+   driven by the same workload. */
+struct table_ops
+  {
+    const char *name;
+    void (*init) (void *table, hash_hash_func *);
+    struct hash_elem *(*insert) (void *table, struct hash_elem *);
+    struct hash_elem *(*find) (void *table, struct hash_elem *);
+    struct hash_elem *(*delete) (void *table, struct hash_elem *);
+    void (*destroy) (void *table);
+  };
+
+static void
+chained_init (void *h, hash_hash_func *hash)
+{
+  if (!hash_init (h, hash, value_less, NULL))
+    PANIC ("out of memory");
+}
+
+static struct hash_elem *
+chained_insert (void *h, struct hash_elem *e)
+{
+  return hash_insert (h, e);
+}
+
+static struct hash_elem *
+chained_find (void *h, struct hash_elem *e)
+{
+  return hash_find (h, e);
+}
+
+static struct hash_elem *
+chained_delete (void *h, struct hash_elem *e)
+{
+  return hash_delete (h, e);
+}
+
+static void
+chained_destroy (void *h)
+{
+  hash_destroy (h, NULL);
+}
+
+static void
+open_init (void *h, hash_hash_func *hash)
+{
+  if (!ohash_init (h, hash, value_less, NULL))
+    PANIC ("out of memory");
+}
+
+static struct hash_elem *
+open_insert (void *h, struct hash_elem *e)
+{
+  return ohash_insert (h, e);
+}
+
+static struct hash_elem *
+open_find (void *h, struct hash_elem *e)
+{
+  return ohash_find (h, e);
+}
+
+static struct hash_elem *
+open_delete (void *h, struct hash_elem *e)
+{
+  return ohash_delete (h, e);
+}
+
+static void
+open_destroy (void *h)
+{
+  ohash_destroy (h, NULL);
+}
+
+static const struct table_ops chained_ops =
+  {"chained", chained_init, chained_insert, chained_find, chained_delete,
+   chained_destroy};
+static const struct table_ops open_ops =
+  {"open", open_init, open_insert, open_find, open_delete, open_destroy};
+
+static void run_workload (const char *name, hash_hash_func *,
+                          struct value[], struct value[], size_t cnt);
+static void shuffle (struct value[], size_t);
+
+/* Benchmark the hash table implementations. */
+void
+test_hash_bench (void)
+{
+  static struct value pages[PAGE_CNT], absent_pages[PAGE_CNT];
+  static struct value fds[FD_CNT], absent_fds[FD_CNT];
+  size_t i;
+
+  /* A process image: code and data from the usual load address
+     upward, and a stack growing down from PHYS_BASE.  Absent
+     pages lie in the gap between. */
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      uintptr_t base = i < PAGE_CNT * 3 / 4 ? 0x08048000 : 0;
+      if (base != 0)
+        pages[i].key = base + i * PGSIZE;
+      else
+        pages[i].key = (uintptr_t) PHYS_BASE - (PAGE_CNT - i) * PGSIZE;
+      absent_pages[i].key = 0x10000000 + i * PGSIZE;
+    }
+  shuffle (pages, PAGE_CNT);
+
+  /* Descriptors are handed out from 2 upward. */
+  for (i = 0; i < FD_CNT; i++)
+    {
+      fds[i].key = i + 2;
+      absent_fds[i].key = FD_CNT + i + 2;
+    }
+
+  run_workload ("page table", page_hash, pages, absent_pages, PAGE_CNT);
+  run_workload ("file table", fd_hash, fds, absent_fds, FD_CNT);
+
+  pass ();
+}
+
+/* Times OPS->insert of the CNT elements in VALUES into a fresh
+   table that hashes with HASH, then lookups of each of them and
+   of each element of ABSENT, which must not be found, then
+   deletion of each of VALUES.  Prints cycles per operation. */
+static void
+time_table (const struct table_ops *ops, void *table, hash_hash_func *hash,
+            struct value values[], struct value absent[], size_t cnt)
+{
+  uint64_t start, insert, hit, miss, delete;
+  size_t i;
+  int round;
+
+  ops->init (table, hash);
+
+  start = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    ASSERT (ops->insert (table, &values[i].elem) == NULL);
+  insert = rdtsc () - start;
+
+  start = rdtsc ();
+  for (round = 0; round < LOOKUP_ROUNDS; round++)
+    for (i = 0; i < cnt; i++)
+      ASSERT (ops->find (table, &values[i].elem) == &values[i].elem);
+  hit = rdtsc () - start;
+
+  start = rdtsc ();
+  for (round = 0; round < LOOKUP_ROUNDS; round++)
+    for (i = 0; i < cnt; i++)
+      ASSERT (ops->find (table, &absent[i].elem) == NULL);
+  miss = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    ASSERT (ops->delete (table, &values[i].elem) == &values[i].elem);
+  delete = rdtsc () - start;
+
+  ops->destroy (table);
+
+  msg ("  %-8s insert %5llu, hit %5llu, miss %5llu, delete %5llu"
+       " cycles/op", ops->name,
+          insert / cnt, hit / (cnt * LOOKUP_ROUNDS),
+          miss / (cnt * LOOKUP_ROUNDS), delete / cnt);
+}
+
+/* Runs the workload named NAME against both kinds of table. */
+static void
+run_workload (const char *name, hash_hash_func *hash,
+              struct value values[], struct value absent[], size_t cnt)
+{
+  struct hash chained;
+  struct ohash open;
+
+  msg ("%s, %zu elements:", name, cnt);
+  time_table (&chained_ops, &chained, hash, values, absent, cnt);
+  time_table (&open_ops, &open, hash, values, absent, cnt);
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle (struct value *array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      struct value t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Hashes a page address as the supplemental page table does. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct value *v = hash_entry (e, struct value, elem);
+  return v->key >> PGBITS;
+}
+
+/* Hashes a file descriptor. */
+static unsigned
+fd_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct value *v = hash_entry (e, struct value, elem);
+  return hash_int (v->key);
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = hash_entry (a_, struct value, elem);
+  const struct value *b = hash_entry (b_, struct value, elem);
+
+  return a->key < b->key;
+}
@@ -0,0 +1,77 @@
+/* Measures page allocator throughput.  Repeatedly allocates and
+   frees a batch of single kernel pages, once through
+   palloc_get_page() and palloc_free_page(), which use the
+   per-pool page cache, and once through palloc_get_multiple()
+   and palloc_free_multiple(), which go straight to the buddy
+   allocator, and reports how many pages each way handled per
+   timer tick.
+
+   This is a benchmark, not a pass/fail test, so it is not part
+   of the graded test suite.  Run it with "run palloc-bench". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "devices/timer.h"
+
+/* Pages held at once in each round. */
+#define BATCH 24
+
+/* Timer ticks to run each variant for. */
+#define BENCH_TICKS 50
+
+static void *pages[BATCH];
+
+/* Allocates and frees BATCH pages via the page cache. */
+static void
+cached_round (void) 
+{
+  int i;
+
+  for (i = 0; i < BATCH; i++)
+    pages[i] = palloc_get_page (PAL_ASSERT);
+  for (i = 0; i < BATCH; i++)
+    palloc_free_page (pages[i]);
+}
+
+/* Allocates and frees BATCH pages via the buddy allocator. */
+static void
+uncached_round (void) 
+{
+  int i;
+
+  for (i = 0; i < BATCH; i++)
+    pages[i] = palloc_get_multiple (PAL_ASSERT, 1);
+  for (i = 0; i < BATCH; i++)
+    palloc_free_multiple (pages[i], 1);
+}
+
+/* Runs ROUND repeatedly for BENCH_TICKS ticks and reports the
+   number of pages allocated and freed per tick. */
+static void
+bench (const char *name, void (*round) (void)) 
+{
+  long long pages_done = 0;
+  int64_t start;
+
+  /* Start on a tick boundary. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+
+  start = timer_ticks ();
+  while (timer_elapsed (start) < BENCH_TICKS)
+    {
+      round ();
+      pages_done += BATCH;
+    }
+  msg ("%s: %lld pages per tick", name, pages_done / BENCH_TICKS);
+}
+
+void
+test_palloc_bench (void) 
+{
+  bench ("palloc_get_page (cached)", cached_round);
+  bench ("palloc_get_multiple (uncached)", uncached_round);
+  pass ();
+}
@@ -0,0 +1,129 @@
+/* Measures the speed of the block and string functions in
+   lib/string.c.  For each of several block sizes, times many
+   calls of each function with the CPU time-stamp counter and
+   reports bytes processed per cycle.
+
+   This is a benchmark, not a pass/fail test, so it is not part
+   of the graded test suite.  Run it with "run string-bench". */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Bytes handled by each function in a size class. */
+#define BENCH_BYTES (256 * 1024)
+
+/* Source and destination buffers, one page each. */
+static uint8_t *src, *dst;
+
+/* Functions to time. */
+static void
+do_memcpy (size_t size) 
+{
+  memcpy (dst, src, size);
+}
+
+static void
+do_memmove (size_t size) 
+{
+  /* Overlapping, so that the copy runs backward. */
+  memmove (dst + 1, dst, size - 1);
+}
+
+static void
+do_memset (size_t size) 
+{
+  memset (dst, 0, size);
+}
+
+static void
+do_memcmp (size_t size) 
+{
+  if (memcmp (dst, src, size) != 0)
+    fail ("memcmp found a difference");
+}
+
+static void
+do_strlen (size_t size) 
+{
+  if (strlen ((char *) src) != size - 1)
+    fail ("strlen returned wrong length");
+}
+
+static void
+do_memchr (size_t size) 
+{
+  if (memchr (src, 'x', size) != NULL)
+    fail ("memchr found a byte not in the block");
+}
+
+struct bench 
+  {
+    const char *name;
+    void (*func) (size_t size);
+  };
+
+static const struct bench benches[] = 
+  {
+    {"memcpy", do_memcpy},
+    {"memmove", do_memmove},
+    {"memset", do_memset},
+    {"memcmp", do_memcmp},
+    {"strlen", do_strlen},
+    {"memchr", do_memchr},
+  };
+
+/* Block sizes to try. */
+static const size_t sizes[] = {16, 64, 256, 1024, PGSIZE};
+
+/* Sets up SRC as a SIZE-byte string and DST as a copy of it. */
+static void
+prepare (size_t size) 
+{
+  memset (src, 'a', size - 1);
+  src[size - 1] = '\0';
+  memcpy (dst, src, size);
+}
+
+void
+test_string_bench (void) 
+{
+  size_t i, j;
+
+  src = palloc_get_page (PAL_ASSERT);
+  dst = palloc_get_page (PAL_ASSERT);
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    for (j = 0; j < sizeof benches / sizeof *benches; j++)
+      {
+        size_t size = sizes[i];
+        size_t iters = BENCH_BYTES / size;
+        enum intr_level old_level;
+        uint64_t start, cycles;
+        size_t k;
+
+        prepare (size);
+
+        /* Keep the timer interrupt out of the measurement. */
+        old_level = intr_disable ();
+        start = rdtsc ();
+        for (k = 0; k < iters; k++)
+          benches[j].func (size);
+        cycles = rdtsc () - start;
+        intr_set_level (old_level);
+
+        if (cycles == 0)
+          cycles = 1;
+        msg ("%s %zu: %llu.%02llu bytes/cycle", benches[j].name, size,
+             (unsigned long long) BENCH_BYTES / cycles,
+             (unsigned long long) BENCH_BYTES * 100 / cycles % 100);
+      }
+
+  palloc_free_page (src);
+  palloc_free_page (dst);
+  pass ();
+}
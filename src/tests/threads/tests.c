@@ -39,6 +39,9 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"hash-bench", test_hash_bench},
+    {"palloc-bench", test_palloc_bench},
+    {"string-bench", test_string_bench},
   };
 
 static const char *test_name;
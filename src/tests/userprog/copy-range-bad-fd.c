@@ -0,0 +1,16 @@
+/* Passes copy_range() an output handle that is not open.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  copy_range (handle, 5678, 10);
+  fail ("should not have survived copy_range()");
+}
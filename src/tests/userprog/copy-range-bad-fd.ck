@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-bad-fd) begin
+(copy-range-bad-fd) open "sample.txt"
+copy-range-bad-fd: exit(-1)
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Copies a file larger than copy_range()'s kernel buffer with a
+   single copy_range() call and checks the byte count, both file
+   positions, and the copy's contents. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE 20000
+
+static char buf[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  int in, out, byte_cnt;
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = i * 7 + i / 512;
+
+  CHECK (create ("in.txt", sizeof buf), "create \"in.txt\"");
+  CHECK ((in = open ("in.txt")) > 1, "open \"in.txt\"");
+  CHECK (write (in, buf, sizeof buf) == sizeof buf, "write \"in.txt\"");
+  seek (in, 0);
+
+  CHECK (create ("out.txt", sizeof buf), "create \"out.txt\"");
+  CHECK ((out = open ("out.txt")) > 1, "open \"out.txt\"");
+
+  byte_cnt = copy_range (in, out, sizeof buf);
+  if (byte_cnt != sizeof buf)
+    fail ("copy_range() returned %d instead of %zu", byte_cnt, sizeof buf);
+  CHECK (tell (in) == sizeof buf, "input position advanced");
+  CHECK (tell (out) == sizeof buf, "output position advanced");
+  close (in);
+  close (out);
+
+  check_file ("out.txt", buf, sizeof buf);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-normal) begin
+(copy-range-normal) create "in.txt"
+(copy-range-normal) open "in.txt"
+(copy-range-normal) write "in.txt"
+(copy-range-normal) create "out.txt"
+(copy-range-normal) open "out.txt"
+(copy-range-normal) input position advanced
+(copy-range-normal) output position advanced
+(copy-range-normal) open "out.txt" for verification
+(copy-range-normal) verified contents of "out.txt"
+(copy-range-normal) close "out.txt"
+(copy-range-normal) end
+copy-range-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Asks copy_range() for more bytes than "sample.txt" holds.  It
+   must copy the whole file, return its size, and then return 0
+   at end of file. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int in, out, byte_cnt;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("out.txt", sizeof sample - 1), "create \"out.txt\"");
+  CHECK ((out = open ("out.txt")) > 1, "open \"out.txt\"");
+
+  byte_cnt = copy_range (in, out, 1000);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("copy_range() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1);
+  CHECK (tell (in) == sizeof sample - 1, "input position advanced");
+  CHECK (tell (out) == sizeof sample - 1, "output position advanced");
+
+  byte_cnt = copy_range (in, out, 1000);
+  if (byte_cnt != 0)
+    fail ("copy_range() at end of file returned %d instead of 0", byte_cnt);
+  close (in);
+  close (out);
+
+  check_file ("out.txt", sample, sizeof sample - 1);
+}
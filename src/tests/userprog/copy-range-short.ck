@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-short) begin
+(copy-range-short) open "sample.txt"
+(copy-range-short) create "out.txt"
+(copy-range-short) open "out.txt"
+(copy-range-short) input position advanced
+(copy-range-short) output position advanced
+(copy-range-short) open "out.txt" for verification
+(copy-range-short) verified contents of "out.txt"
+(copy-range-short) close "out.txt"
+(copy-range-short) end
+copy-range-short: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Passes readv() and writev() vector lengths of 0, -1, and
+   IOV_MAX + 1.  A length of 0 must transfer nothing and return
+   0; the others must return -1. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static char buf[IOV_MAX + 1];
+  static struct iovec iov[IOV_MAX + 1];
+  int handle;
+  int i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  for (i = 0; i <= IOV_MAX; i++)
+    {
+      iov[i].iov_base = buf + i;
+      iov[i].iov_len = 1;
+    }
+
+  CHECK (readv (handle, iov, 0) == 0, "readv 0 buffers");
+  CHECK (readv (handle, iov, -1) == -1, "readv -1 buffers");
+  CHECK (readv (handle, iov, IOV_MAX + 1) == -1,
+         "readv IOV_MAX + 1 buffers");
+  CHECK (writev (handle, iov, 0) == 0, "writev 0 buffers");
+  CHECK (writev (handle, iov, -1) == -1, "writev -1 buffers");
+  CHECK (writev (handle, iov, IOV_MAX + 1) == -1,
+         "writev IOV_MAX + 1 buffers");
+  CHECK (tell (handle) == 0, "file position unchanged");
+}
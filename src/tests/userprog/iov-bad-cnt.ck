@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(iov-bad-cnt) begin
+(iov-bad-cnt) open "sample.txt"
+(iov-bad-cnt) readv 0 buffers
+(iov-bad-cnt) readv -1 buffers
+(iov-bad-cnt) readv IOV_MAX + 1 buffers
+(iov-bad-cnt) writev 0 buffers
+(iov-bad-cnt) writev -1 buffers
+(iov-bad-cnt) writev IOV_MAX + 1 buffers
+(iov-bad-cnt) file position unchanged
+(iov-bad-cnt) end
+iov-bad-cnt: exit(0)
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Reads "sample.txt" with pread() at explicit offsets, including
+   a short read at end of file, and checks that the file position
+   is left alone. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[20];
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (handle, 5);
+
+  byte_cnt = pread (handle, buf, sizeof buf, 100);
+  if (byte_cnt != sizeof buf)
+    fail ("pread() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample + 100, sizeof buf, 100, "sample.txt");
+
+  byte_cnt = pread (handle, buf, sizeof buf, sizeof sample - 1 - 9);
+  if (byte_cnt != 9)
+    fail ("pread() at end of file returned %d instead of 9", byte_cnt);
+  compare_bytes (buf, sample + sizeof sample - 1 - 9, 9,
+                 sizeof sample - 1 - 9, "sample.txt");
+
+  CHECK (tell (handle) == 5, "file position unchanged");
+}
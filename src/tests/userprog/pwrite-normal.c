@@ -0,0 +1,31 @@
+/* Writes a file with pwrite() at explicit offsets, back to
+   front, and checks that the file position is left alone and
+   that the file's contents are right. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  seek (handle, 7);
+
+  byte_cnt = pwrite (handle, sample + 100, sizeof sample - 1 - 100, 100);
+  if (byte_cnt != sizeof sample - 1 - 100)
+    fail ("pwrite() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1 - 100);
+  byte_cnt = pwrite (handle, sample, 100, 0);
+  if (byte_cnt != 100)
+    fail ("pwrite() returned %d instead of 100", byte_cnt);
+
+  CHECK (tell (handle) == 7, "file position unchanged");
+  close (handle);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,33 @@
+/* Asks readv() for more bytes than "sample.txt" holds.  It must
+   return the file's size, filling the buffers in order, and then
+   return 0 at end of file. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char a[200], b[100];
+  struct iovec iov[2];
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  iov[0].iov_base = a;
+  iov[0].iov_len = sizeof a;
+  iov[1].iov_base = b;
+  iov[1].iov_len = sizeof b;
+  byte_cnt = readv (handle, iov, 2);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes (b, sample + sizeof a, sizeof sample - 1 - sizeof a,
+                 sizeof a, "sample.txt");
+
+  byte_cnt = readv (handle, iov, 2);
+  if (byte_cnt != 0)
+    fail ("readv() at end of file returned %d instead of 0", byte_cnt);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-short) begin
+(readv-short) open "sample.txt"
+(readv-short) end
+readv-short: exit(0)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Submits a system call ring whose head is more than
+   SYS_RING_SIZE entries past its tail.  The submission must
+   return -1 without making any call. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring;
+
+void
+test_main (void) 
+{
+  int i;
+
+  sys_ring_init (&ring);
+  for (i = 0; i < SYS_RING_SIZE; i++)
+    {
+      ring.ops[i].call_nr = SYS_EXIT;
+      ring.ops[i].args[0] = 57;
+    }
+  ring.head = ring.tail + SYS_RING_SIZE + 1;
+
+  CHECK (sys_ring_submit (&ring) == -1, "submit overfull ring");
+  CHECK (ring.tail == 0, "tail unchanged");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad-index) begin
+(ring-bad-index) submit overfull ring
+(ring-bad-index) tail unchanged
+(ring-bad-index) end
+ring-bad-index: exit(0)
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Queues calls that may not be made from a system call ring:
+   exit, exec, and ring submission itself.  Each must complete
+   with -1 without taking effect, and a later call in the same
+   ring must still be made. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring;
+
+void
+test_main (void) 
+{
+  struct sys_op *exit_op, *exec_op, *submit_op, *size_op;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  sys_ring_init (&ring);
+  exit_op = sys_ring_queue (&ring, SYS_EXIT, 57, 0, 0, 0);
+  exec_op = sys_ring_queue (&ring, SYS_EXEC, (int) "child-simple",
+                            0, 0, 0);
+  submit_op = sys_ring_queue (&ring, SYS_RING_SUBMIT, (int) &ring,
+                              0, 0, 0);
+  size_op = sys_ring_queue (&ring, SYS_FILESIZE, handle, 0, 0, 0);
+  CHECK (sys_ring_submit (&ring) == 4, "submit 4 calls");
+  CHECK (ring.tail == 4, "tail advanced past 4 calls");
+
+  CHECK (exit_op->result == -1, "exit refused");
+  CHECK (exec_op->result == -1, "exec refused");
+  CHECK (submit_op->result == -1, "ring submit refused");
+  CHECK (size_op->result == sizeof sample - 1, "filesize made");
+}
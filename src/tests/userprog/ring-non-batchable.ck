@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-non-batchable) begin
+(ring-non-batchable) open "sample.txt"
+(ring-non-batchable) submit 4 calls
+(ring-non-batchable) tail advanced past 4 calls
+(ring-non-batchable) exit refused
+(ring-non-batchable) exec refused
+(ring-non-batchable) ring submit refused
+(ring-non-batchable) filesize made
+(ring-non-batchable) end
+ring-non-batchable: exit(0)
+EOF
+pass;
@@ -0,0 +1,42 @@
+/* Queues several different system calls in a system call ring,
+   submits them with one call, and checks each result, the data
+   read, and the ring's tail. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring;
+
+void
+test_main (void) 
+{
+  char buf[20], buf2[10];
+  struct sys_op *seek_op, *read_op, *tell_op, *size_op, *pread_op;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  sys_ring_init (&ring);
+  seek_op = sys_ring_queue (&ring, SYS_SEEK, handle, 100, 0, 0);
+  read_op = sys_ring_queue (&ring, SYS_READ, handle, (int) buf,
+                            sizeof buf, 0);
+  tell_op = sys_ring_queue (&ring, SYS_TELL, handle, 0, 0, 0);
+  size_op = sys_ring_queue (&ring, SYS_FILESIZE, handle, 0, 0, 0);
+  pread_op = sys_ring_queue (&ring, SYS_PREAD, handle, (int) buf2,
+                             sizeof buf2, 0);
+  CHECK (sys_ring_submit (&ring) == 5, "submit 5 calls");
+  CHECK (ring.tail == 5, "tail advanced past 5 calls");
+
+  CHECK (seek_op->result == 0, "seek result");
+  CHECK (read_op->result == sizeof buf, "read result");
+  compare_bytes (buf, sample + 100, sizeof buf, 100, "sample.txt");
+  CHECK (tell_op->result == 100 + sizeof buf, "tell result");
+  CHECK (size_op->result == sizeof sample - 1, "filesize result");
+  CHECK (pread_op->result == sizeof buf2, "pread result");
+  compare_bytes (buf2, sample, sizeof buf2, 0, "sample.txt");
+
+  CHECK (sys_ring_reap (&ring) == seek_op, "reap first call");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-normal) begin
+(ring-normal) open "sample.txt"
+(ring-normal) submit 5 calls
+(ring-normal) tail advanced past 5 calls
+(ring-normal) seek result
+(ring-normal) read result
+(ring-normal) tell result
+(ring-normal) filesize result
+(ring-normal) pread result
+(ring-normal) reap first call
+(ring-normal) end
+ring-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,55 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdint.h>
+
+/* Returns the processor's time-stamp counter, which counts CPU
+   cycles since reset.  Available on Pentium and later. */
+static inline uint64_t
+rdtsc (void)
+{
+  /* See [IA32-v2b] "RDTSC". */
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* CPUID leaf 1 feature flags, in EDX. */
+#define CPUID_SEP (1u << 11)    /* SYSENTER and SYSEXIT. */
+
+/* Executes CPUID for LEAF, storing EAX, EBX, ECX, and EDX into
+   REGS[0] through REGS[3]. */
+static inline void
+cpuid (uint32_t leaf, uint32_t regs[4])
+{
+  /* See [IA32-v2a] "CPUID". */
+  asm volatile ("cpuid"
+                : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]),
+                  "=d" (regs[3])
+                : "a" (leaf), "c" (0));
+}
+
+/* Model-specific registers. */
+#define MSR_SYSENTER_CS  0x174  /* SYSENTER code segment. */
+#define MSR_SYSENTER_ESP 0x175  /* SYSENTER stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* SYSENTER entry point. */
+
+/* Returns the value of model-specific register MSR. */
+static inline uint64_t
+rdmsr (uint32_t msr)
+{
+  /* See [IA32-v2b] "RDMSR". */
+  uint64_t value;
+  asm volatile ("rdmsr" : "=A" (value) : "c" (msr));
+  return value;
+}
+
+/* Sets model-specific register MSR to VALUE. */
+static inline void
+wrmsr (uint32_t msr, uint64_t value)
+{
+  /* See [IA32-v2b] "WRMSR". */
+  asm volatile ("wrmsr" : : "c" (msr), "A" (value));
+}
+
+#endif /* threads/cpu.h */
@@ -17,11 +17,14 @@
 #include "devices/rtc.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/kmem.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -37,6 +40,11 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -54,15 +62,29 @@ static const char *swap_bdev_name;
 #endif
 #endif /* FILESYS */
 
+/* -trace: Number of pages for the event trace, 0 for no trace. */
+static size_t trace_pages;
+
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+#ifdef VM
+/* -pager-low, -pager-high: Free frame watermarks for the pager. */
+static size_t pager_low_water = SIZE_MAX;
+static size_t pager_high_water = SIZE_MAX;
+#endif
+
 static void bss_init (void);
 static void paging_init (void);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
+static int option_value (const char *name, const char *value);
 static void run_actions (char **argv);
+static void print_kmem_stats (char **argv);
+#ifdef MALLOC_PROFILE
+static void print_malloc_profile (char **argv);
+#endif
 static void usage (void);
 
 #ifdef FILESYS
@@ -98,6 +120,8 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  if (trace_pages > 0)
+    trace_init (trace_pages);
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -127,6 +151,13 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  page_init ();
+  frame_init (pager_low_water, pager_high_water);
+  swap_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -223,6 +254,16 @@ read_command_line (void)
   return argv;
 }
 
+/* Returns the numeric VALUE given for option NAME.
+   Panics if the option was given without a value. */
+static int
+option_value (const char *name, const char *value) 
+{
+  if (value == NULL)
+    PANIC ("option `%s' requires a value (use -h for help)", name);
+  return atoi (value);
+}
+
 /* Parses options in ARGV[]
    and returns the first non-option argument. */
 static char **
@@ -256,9 +297,25 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-profile"))
+        profile_on = true;
+      else if (!strcmp (name, "-trace"))
+        trace_pages = value != NULL ? atoi (value) : 16;
+      else if (!strcmp (name, "-serial-txq"))
+        serial_txq_size = option_value (name, value);
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-no-sysenter"))
+        syscall_sysenter = false;
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-pager-low"))
+        pager_low_water = option_value (name, value);
+      else if (!strcmp (name, "-pager-high"))
+        pager_high_water = option_value (name, value);
+      else if (!strcmp (name, "-vmstat"))
+        page_stats_on_exit = true;
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -292,6 +349,23 @@ run_task (char **argv)
   printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints statistics for the kernel object caches. */
+static void
+print_kmem_stats (char **argv UNUSED)
+{
+  kmem_print_stats ();
+}
+
+#ifdef MALLOC_PROFILE
+/* Prints malloc() statistics and the ARGV[1] call sites that
+   hold the most memory. */
+static void
+print_malloc_profile (char **argv)
+{
+  malloc_print_profile (atoi (argv[1]));
+}
+#endif
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -309,6 +383,10 @@ run_actions (char **argv)
   static const struct action actions[] = 
     {
       {"run", 2, run_task},
+      {"kmemstat", 1, print_kmem_stats},
+#ifdef MALLOC_PROFILE
+      {"mallocstat", 2, print_malloc_profile},
+#endif
 #ifdef FILESYS
       {"ls", 1, fsutil_ls},
       {"cat", 2, fsutil_cat},
@@ -356,6 +434,10 @@ usage (void)
           "  run 'PROG [ARG...]' Run PROG and wait for it to complete.\n"
 #else
           "  run TEST           Run TEST.\n"
+#endif
+          "  kmemstat           Print kernel object cache statistics.\n"
+#ifdef MALLOC_PROFILE
+          "  mallocstat N       Print malloc statistics and top N call sites.\n"
 #endif
 #ifdef FILESYS
           "  ls                 List files in the root directory.\n"
@@ -379,8 +461,17 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -profile           Sample the running code on each timer tick.\n"
+          "  -trace[=PAGES]     Record events in a PAGES-page buffer (default 16).\n"
+          "  -serial-txq=BYTES  Queue up to BYTES of serial output (default 4096).\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -no-sysenter       Make system calls use only \"int $0x30\".\n"
+#endif
+#ifdef VM
+          "  -pager-low=COUNT   Wake the pager below COUNT free frames.\n"
+          "  -pager-high=COUNT  Have the pager free up to COUNT frames.\n"
+          "  -vmstat            Print paging statistics as processes exit.\n"
 #endif
           );
   shutdown_power_off ();
@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -37,6 +38,34 @@ static const char *intr_names[INTR_CNT];
    unexpected interrupt is one that has no registered handler. */
 static unsigned int unexpected_cnt[INTR_CNT];
 
+/* Handler durations are kept as histograms with one bucket per
+   power of 2 cycles.  Bucket I counts handlers that ran for less
+   than 2**(HIST_MIN_BITS + I + 1) cycles, and the last bucket
+   all the longer ones. */
+#define HIST_MIN_BITS 8
+#define HIST_CNT 16
+
+/* Statistics for one interrupt vector. */
+struct intr_stats
+  {
+    unsigned cnt;               /* Number of times invoked. */
+    uint64_t cycles;            /* Total cycles spent in handler. */
+    uint32_t max_cycles;        /* Longest time in handler. */
+    unsigned hist[HIST_CNT];    /* Handler durations. */
+  };
+static struct intr_stats intr_stats[INTR_CNT];
+
+/* Longest window with interrupts disabled.  A window opens when
+   intr_disable() turns interrupts off, or when an interrupt gate
+   turns them off on entry to intr_handler(), and closes when
+   intr_enable() turns them back on.  Windows that close by
+   returning from an interrupt are covered by the handler
+   statistics instead. */
+static uint64_t intr_off_start;     /* When the current window opened. */
+static void *intr_off_pc;           /* Where the current window opened. */
+static uint64_t intr_off_max;       /* Length of the longest window. */
+static void *intr_off_max_pc;       /* Where the longest window opened. */
+
 /* External interrupts are those generated by devices outside the
    CPU, such as the timer.  External interrupts run with
    interrupts turned off, so they never nest, nor are they ever
@@ -59,6 +88,7 @@ static inline uint64_t make_idtr_operand (uint16_t limit, void *base);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 static void unexpected_interrupt (const struct intr_frame *);
+static int hist_bucket (uint64_t cycles);
 
 /* Returns the current interrupt status. */
 enum intr_level
@@ -90,6 +120,19 @@ intr_enable (void)
   enum intr_level old_level = intr_get_level ();
   ASSERT (!intr_context ());
 
+  /* Close the window opened by the last intr_disable().  The
+     boot code runs with interrupts off before any window has
+     been opened, so ignore that. */
+  if (old_level == INTR_OFF && intr_off_start != 0)
+    {
+      uint64_t length = rdtsc () - intr_off_start;
+      if (length > intr_off_max)
+        {
+          intr_off_max = length;
+          intr_off_max_pc = intr_off_pc;
+        }
+    }
+
   /* Enable interrupts by setting the interrupt flag.
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -110,6 +153,13 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+  /* Open a window, unless one is already open. */
+  if (old_level == INTR_ON)
+    {
+      intr_off_start = rdtsc ();
+      intr_off_pc = __builtin_return_address (0);
+    }
+
   return old_level;
 }
 
@@ -346,6 +396,17 @@ intr_handler (struct intr_frame *frame)
 {
   bool external;
   intr_handler_func *handler;
+  struct intr_stats *stats = &intr_stats[frame->vec_no];
+  uint64_t start = rdtsc ();
+  uint64_t cycles;
+
+  /* If we came through an interrupt gate, it turned interrupts
+     off: that opens a window. */
+  if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+    {
+      intr_off_start = start;
+      intr_off_pc = frame->eip;
+    }
 
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
@@ -374,6 +435,15 @@ intr_handler (struct intr_frame *frame)
   else
     unexpected_interrupt (frame);
 
+  /* Account for the time spent in the handler, which for
+     internal interrupts includes any time it spent blocked. */
+  cycles = rdtsc () - start;
+  stats->cnt++;
+  stats->cycles += cycles;
+  if (cycles > stats->max_cycles)
+    stats->max_cycles = cycles < UINT32_MAX ? cycles : UINT32_MAX;
+  stats->hist[hist_bucket (cycles)]++;
+
   /* Complete the processing of an external interrupt. */
   if (external) 
     {
@@ -388,6 +458,22 @@ intr_handler (struct intr_frame *frame)
     }
 }
 
+/* Returns the histogram bucket for a handler that ran for
+   CYCLES cycles. */
+static int
+hist_bucket (uint64_t cycles)
+{
+  int bits;
+
+  if (cycles >= (1u << (HIST_MIN_BITS + HIST_CNT - 1)))
+    return HIST_CNT - 1;
+  else if (cycles < (1u << HIST_MIN_BITS))
+    return 0;
+
+  bits = 31 - __builtin_clz ((uint32_t) cycles);
+  return bits - HIST_MIN_BITS;
+}
+
 /* Handles an unexpected interrupt with interrupt frame F.  An
    unexpected interrupt is one that has no registered handler. */
 static void
@@ -436,3 +522,38 @@ intr_name (uint8_t vec)
 {
   return intr_names[vec];
 }
+
+/* Prints interrupt statistics: for each vector that has fired,
+   how often and how long its handler ran, as a histogram over
+   powers of 2 cycles, followed by the longest period that
+   interrupts were disabled. */
+void
+intr_print_stats (void) 
+{
+  int vec;
+
+  for (vec = 0; vec < INTR_CNT; vec++)
+    {
+      const struct intr_stats *s = &intr_stats[vec];
+      int i;
+
+      if (s->cnt == 0)
+        continue;
+      printf ("Interrupt %#04x (%s): %u calls, %"PRIu64" cycles avg, "
+              "%"PRIu32" max\n",
+              vec, intr_names[vec], s->cnt, s->cycles / s->cnt,
+              s->max_cycles);
+      printf ("  cycles:");
+      for (i = 0; i < HIST_CNT; i++)
+        if (s->hist[i] != 0)
+          {
+            if (i < HIST_CNT - 1)
+              printf (" <2^%d:%u", HIST_MIN_BITS + i + 1, s->hist[i]);
+            else
+              printf (" >=2^%d:%u", HIST_MIN_BITS + i, s->hist[i]);
+          }
+      printf ("\n");
+    }
+  printf ("Interrupts: longest disabled %"PRIu64" cycles, from %p\n",
+          intr_off_max, intr_off_max_pc);
+}
@@ -66,5 +66,6 @@ void intr_yield_on_return (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
+void intr_print_stats (void);
 
 #endif /* threads/interrupt.h */
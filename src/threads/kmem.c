@@ -0,0 +1,292 @@
+#include "threads/kmem.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator for fixed-size objects.
+
+   malloc() rounds each request up to a power of 2, so a
+   frequently allocated structure whose size is just over a power
+   of 2 wastes nearly half of every block.  A kmem_cache instead
+   hands out objects of one exact size.  Each cache takes whole
+   pages, called "slabs", from the page allocator and packs as
+   many objects into each as fit after a small header.
+
+   Objects may have a constructor, which runs once per object when
+   its slab is created.  Freed objects are not cleared, so an
+   object comes back from kmem_cache_alloc() in whatever state it
+   was freed in; a user of a constructor must free objects in
+   their constructed state.  To make that possible, the free list
+   is kept as an array of object indexes in the slab header
+   rather than threaded through the objects themselves.
+
+   A slab whose objects have all been freed is not returned to the
+   page allocator at once, since the next allocation would likely
+   need it again.  Up to EMPTY_SLABS_MAX empty slabs are kept per
+   cache.  When kmem_cache_alloc() finds no free page for a new
+   slab, it calls kmem_reap() to release the empty slabs of every
+   cache and tries once more. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Object alignment. */
+#define OBJ_ALIGN sizeof (void *)
+
+/* Maximum number of empty slabs kept by a cache. */
+#define EMPTY_SLABS_MAX 1
+
+/* A slab: one page of objects, with this header at its start. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of cache's lists. */
+    size_t in_use;              /* Number of objects in use. */
+    size_t free_top;            /* Number of entries in free_idx[]. */
+    uint16_t free_idx[];        /* Stack of indexes of free objects. */
+  };
+
+/* All caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+/* Returns the offset within a slab of its first object, if the
+   slab holds OBJ_CNT objects. */
+static size_t
+obj_ofs (size_t obj_cnt)
+{
+  return ROUND_UP (sizeof (struct slab) + obj_cnt * sizeof (uint16_t),
+                   OBJ_ALIGN);
+}
+
+/* Initializes cache C to hand out objects of SIZE bytes,
+   naming it NAME for statistics.  If CTOR is non-null, it is
+   called on each object when its slab is created. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name, size_t size,
+                 kmem_ctor_func *ctor)
+{
+  enum intr_level old_level;
+  size_t n;
+
+  ASSERT (c != NULL);
+  ASSERT (size > 0 && size <= PGSIZE / 4);
+
+  c->name = name;
+  c->obj_size = ROUND_UP (size, OBJ_ALIGN);
+  c->ctor = ctor;
+
+  /* Pack in as many objects as fit with their free-list entries. */
+  n = (PGSIZE - sizeof (struct slab)) / (c->obj_size + sizeof (uint16_t));
+  while (obj_ofs (n) + n * c->obj_size > PGSIZE)
+    n--;
+  c->objs_per_slab = n;
+  c->obj_ofs = obj_ofs (n);
+
+  lock_init (&c->lock);
+  lock_set_name (&c->lock, c->name);
+  list_init (&c->partial_slabs);
+  list_init (&c->full_slabs);
+  list_init (&c->empty_slabs);
+  c->empty_cnt = 0;
+  c->slab_cnt = c->active_cnt = 0;
+  c->alloc_cnt = c->free_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &c->elem);
+  intr_set_level (old_level);
+}
+
+/* Returns object IDX in slab S. */
+static void *
+slab_obj (struct slab *s, size_t idx)
+{
+  return (uint8_t *) s + s->cache->obj_ofs + idx * s->cache->obj_size;
+}
+
+/* Allocates and returns a new, empty slab for cache C, or a null
+   pointer if no page is available. */
+static struct slab *
+slab_create (struct kmem_cache *c)
+{
+  struct slab *s = palloc_get_page (0);
+  size_t i;
+
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+  s->free_top = c->objs_per_slab;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      /* Stack the indexes so that object 0 is handed out first. */
+      s->free_idx[i] = c->objs_per_slab - 1 - i;
+      if (c->ctor != NULL)
+        c->ctor (slab_obj (s, i));
+    }
+  c->slab_cnt++;
+  return s;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if C has no free object and no page is available for a
+   new slab. */
+static void *
+try_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+
+  /* Prefer a partly used slab, then an empty one, so that empty
+     slabs stay empty and can be released. */
+  if (!list_empty (&c->partial_slabs))
+    s = list_entry (list_front (&c->partial_slabs), struct slab, elem);
+  else if (!list_empty (&c->empty_slabs))
+    {
+      s = list_entry (list_pop_front (&c->empty_slabs), struct slab, elem);
+      c->empty_cnt--;
+      list_push_front (&c->partial_slabs, &s->elem);
+    }
+  else
+    {
+      s = slab_create (c);
+      if (s == NULL)
+        {
+          lock_release (&c->lock);
+          return NULL;
+        }
+      list_push_front (&c->partial_slabs, &s->elem);
+    }
+
+  obj = slab_obj (s, s->free_idx[--s->free_top]);
+  if (++s->in_use == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full_slabs, &s->elem);
+    }
+  c->active_cnt++;
+  c->alloc_cnt++;
+
+  lock_release (&c->lock);
+  return obj;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  void *obj = try_cache_alloc (c);
+  if (obj == NULL)
+    {
+      /* Out of pages.  Empty slabs held by any cache, including
+         C, can be given back and reused. */
+      kmem_reap ();
+      obj = try_cache_alloc (c);
+    }
+  return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+  size_t idx;
+
+  if (obj == NULL)
+    return;
+
+  s = pg_round_down (obj);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  idx = ((uint8_t *) obj - (uint8_t *) slab_obj (s, 0)) / c->obj_size;
+  ASSERT (slab_obj (s, idx) == obj);
+
+  lock_acquire (&c->lock);
+
+  ASSERT (s->free_top < c->objs_per_slab);
+  s->free_idx[s->free_top++] = idx;
+  if (s->in_use-- == c->objs_per_slab)
+    {
+      /* Was full. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial_slabs, &s->elem);
+    }
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->empty_slabs, &s->elem);
+      if (++c->empty_cnt > EMPTY_SLABS_MAX)
+        {
+          /* Release the least recently emptied slab. */
+          struct slab *victim = list_entry (list_pop_back (&c->empty_slabs),
+                                            struct slab, elem);
+          c->empty_cnt--;
+          c->slab_cnt--;
+          palloc_free_page (victim);
+        }
+    }
+  c->active_cnt--;
+  c->free_cnt++;
+
+  lock_release (&c->lock);
+}
+
+/* Returns all of cache C's empty slabs to the page allocator. */
+void
+kmem_cache_reap (struct kmem_cache *c)
+{
+  lock_acquire (&c->lock);
+  while (!list_empty (&c->empty_slabs))
+    {
+      struct slab *s = list_entry (list_pop_front (&c->empty_slabs),
+                                   struct slab, elem);
+      c->empty_cnt--;
+      c->slab_cnt--;
+      palloc_free_page (s);
+    }
+  lock_release (&c->lock);
+}
+
+/* Returns the empty slabs of every cache to the page
+   allocator. */
+void
+kmem_reap (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    kmem_cache_reap (list_entry (e, struct kmem_cache, elem));
+}
+
+/* Prints statistics for every cache. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  printf ("%-12s %6s %5s %6s %6s %10s %10s\n",
+          "cache", "size", "/slab", "slabs", "active", "allocs", "frees");
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+      lock_acquire (&c->lock);
+      printf ("%-12s %6zu %5zu %6zu %6zu %10lld %10lld\n",
+              c->name, c->obj_size, c->objs_per_slab, c->slab_cnt,
+              c->active_cnt, c->alloc_cnt, c->free_cnt);
+      lock_release (&c->lock);
+    }
+}
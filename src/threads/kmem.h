@@ -0,0 +1,44 @@
+#ifndef THREADS_KMEM_H
+#define THREADS_KMEM_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Object constructor.  Called once for each object when the page
+   holding it is added to a cache, not on every allocation. */
+typedef void kmem_ctor_func (void *obj);
+
+/* Cache of fixed-size objects.  See kmem.c for details. */
+struct kmem_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Object size in bytes, rounded up. */
+    size_t objs_per_slab;       /* Objects per slab. */
+    size_t obj_ofs;             /* Offset of first object in slab. */
+    kmem_ctor_func *ctor;       /* Constructor, or a null pointer. */
+    struct list_elem elem;      /* Element in list of all caches. */
+
+    struct lock lock;           /* Protects all members below. */
+    struct list partial_slabs;  /* Slabs with some objects in use. */
+    struct list full_slabs;     /* Slabs with every object in use. */
+    struct list empty_slabs;    /* Slabs with no objects in use. */
+    size_t empty_cnt;           /* Number of empty slabs. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Number of slabs. */
+    size_t active_cnt;          /* Number of objects in use. */
+    long long alloc_cnt;        /* # of kmem_cache_alloc() calls. */
+    long long free_cnt;         /* # of kmem_cache_free() calls. */
+  };
+
+void kmem_cache_init (struct kmem_cache *, const char *name, size_t size,
+                      kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_reap (struct kmem_cache *);
+void kmem_reap (void);
+
+void kmem_print_stats (void);
+
+#endif /* threads/kmem.h */
@@ -5,15 +5,19 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  The size classes are the powers
+   of 2 from 16 bytes up, plus the sizes halfway between them
+   (48, 96, 192, ...), so a block wastes at most a third of its
+   space rather than half.  The descriptor keeps a list of free blocks.  If
    the free list is nonempty, one of its blocks is used to
    satisfy the request.
 
@@ -32,13 +36,20 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   realloc() resizes in place whenever it can: a block that
+   already has room for the new size is returned unchanged, and a
+   big block shrinks by freeing its last pages or grows by
+   allocating the pages that follow it, if they are free. */
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    size_t arena_cnt;           /* Number of arenas. */
+    char name[16];              /* Name, for lock statistics. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
   };
@@ -61,12 +72,108 @@ struct block
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[16];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
+#ifdef MALLOC_PROFILE
+/* Allocation profiling.
+
+   When the kernel is built with MALLOC_PROFILE defined (run
+   "make MALLOC_PROFILE=1"), every block carries a hidden tag
+   just before the address returned to the caller.  The tag
+   records the requested size and the call site that asked for
+   the block, identified by its return address, so that free()
+   can charge the block back to the same size class and site.
+   malloc_print_profile() reports what each size class and the
+   busiest call sites are holding. */
+
+/* Allocation counters. */
+struct alloc_stats
+  {
+    size_t alloc_cnt;           /* Number of allocations. */
+    size_t live_cnt;            /* Blocks not yet freed. */
+    size_t live_bytes;          /* Bytes requested in live blocks. */
+    size_t peak_bytes;          /* High-water mark of `live_bytes'. */
+  };
+
+/* A call site. */
+struct site
+  {
+    void *caller;               /* Return address, null if unused. */
+    struct alloc_stats stats;   /* Blocks allocated here. */
+  };
+
+/* Prepended to every block. */
+struct alloc_tag
+  {
+    struct site *site;          /* Allocating call site. */
+    size_t size;                /* Requested size in bytes. */
+  };
+
+/* Call sites, as an open-addressing hash table keyed on
+   `caller'.  Once it fills up, further sites share the last
+   slot, which is never used by the table itself. */
+#define SITE_BITS 8
+#define SITE_CNT (1u << SITE_BITS)
+static struct site sites[SITE_CNT + 1];
+
+/* Counters for each descriptor and for big blocks. */
+static struct alloc_stats desc_stats[sizeof descs / sizeof *descs];
+static struct alloc_stats big_stats;
+
+#define TAG_SIZE (sizeof (struct alloc_tag))
+#define CALLER __builtin_return_address (0)
+
+static void *profile_alloc (void *, size_t, void *caller);
+static void *profile_free (void *);
+static void profile_resize (void *, size_t);
+static void *raw_block (void *);
+#else /* !MALLOC_PROFILE */
+#define TAG_SIZE 0
+#define CALLER NULL
+
+static inline void *
+profile_alloc (void *b, size_t size UNUSED, void *caller UNUSED)
+{
+  return b;
+}
+
+static inline void *
+profile_free (void *p)
+{
+  return p;
+}
+
+static inline void
+profile_resize (void *p UNUSED, size_t size UNUSED)
+{
+}
+
+static inline void *
+raw_block (void *p)
+{
+  return p;
+}
+#endif /* !MALLOC_PROFILE */
+
+/* Adds a descriptor for blocks of BLOCK_SIZE bytes. */
+static void
+add_desc (size_t block_size) 
+{
+  struct desc *d = &descs[desc_cnt++];
+  ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+  d->block_size = block_size;
+  d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+  d->arena_cnt = 0;
+  list_init (&d->free_list);
+  lock_init (&d->lock);
+  snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+  lock_set_name (&d->lock, d->name);
+}
+
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) 
@@ -75,28 +182,22 @@ malloc_init (void)
 
   for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
     {
-      struct desc *d = &descs[desc_cnt++];
-      ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-      d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
-      lock_init (&d->lock);
+      add_desc (block_size);
+      if (block_size >= 32 && block_size * 3 / 2 < PGSIZE / 2)
+        add_desc (block_size * 3 / 2);
     }
 }
 
-/* Obtains and returns a new block of at least SIZE bytes.
+/* Obtains and returns a new block of at least SIZE bytes,
+   without regard to profiling.
    Returns a null pointer if memory is not available. */
-void *
-malloc (size_t size) 
+static void *
+alloc_block (size_t size) 
 {
   struct desc *d;
   struct block *b;
   struct arena *a;
 
-  /* A null pointer satisfies a request for 0 bytes. */
-  if (size == 0)
-    return NULL;
-
   /* Find the smallest descriptor that satisfies a SIZE-byte
      request. */
   for (d = descs; d < descs + desc_cnt; d++)
@@ -143,6 +244,7 @@ malloc (size_t size)
           struct block *b = arena_to_block (a, i);
           list_push_back (&d->free_list, &b->free_elem);
         }
+      d->arena_cnt++;
     }
 
   /* Get a block from free list and return it. */
@@ -153,6 +255,76 @@ malloc (size_t size)
   return b;
 }
 
+/* Frees block B, which must have been obtained from
+   alloc_block(). */
+static void
+free_block (struct block *b) 
+{
+  struct arena *a = block_to_arena (b);
+  struct desc *d = a->desc;
+      
+  if (d != NULL) 
+    {
+      /* It's a normal block.  We handle it here. */
+
+#ifndef NDEBUG
+      /* Clear the block to help detect use-after-free bugs. */
+      memset (b, 0xcc, d->block_size);
+#endif
+  
+      lock_acquire (&d->lock);
+
+      /* Add block to free list. */
+      list_push_front (&d->free_list, &b->free_elem);
+
+      /* If the arena is now entirely unused, free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
+        {
+          size_t i;
+
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_remove (&b->free_elem);
+            }
+          palloc_free_page (a);
+          d->arena_cnt--;
+        }
+
+      lock_release (&d->lock);
+    }
+  else
+    {
+      /* It's a big block.  Free its pages. */
+      palloc_free_multiple (a, a->free_cnt);
+    }
+}
+
+/* Obtains and returns a new block of at least SIZE bytes on
+   behalf of CALLER.
+   Returns a null pointer if memory is not available. */
+static void *
+do_malloc (size_t size, void *caller) 
+{
+  void *b;
+
+  /* A null pointer satisfies a request for 0 bytes. */
+  if (size == 0)
+    return NULL;
+
+  b = alloc_block (size + TAG_SIZE);
+  return b != NULL ? profile_alloc (b, size, caller) : NULL;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size) 
+{
+  return do_malloc (size, CALLER);
+}
+
 /* Allocates and return A times B bytes initialized to zeroes.
    Returns a null pointer if memory is not available. */
 void *
@@ -167,22 +339,61 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = do_malloc (size, CALLER);
   if (p != NULL)
     memset (p, 0, size);
 
   return p;
 }
 
-/* Returns the number of bytes allocated for BLOCK. */
+/* Returns the number of bytes usable in BLOCK. */
 static size_t
 block_size (void *block) 
 {
-  struct block *b = block;
+  struct block *b = raw_block (block);
   struct arena *a = block_to_arena (b);
   struct desc *d = a->desc;
+  size_t size = (d != NULL ? d->block_size
+                 : PGSIZE * a->free_cnt - pg_ofs (b));
 
-  return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
+  return size - TAG_SIZE;
+}
+
+/* Tries to make BLOCK hold at least NEW_SIZE bytes without
+   moving it.  Returns true if successful, false if BLOCK must be
+   moved. */
+static bool
+resize_in_place (void *block, size_t new_size) 
+{
+  struct arena *a = block_to_arena (raw_block (block));
+  size_t page_cnt;
+
+  if (a->desc != NULL)
+    {
+      /* A normal block can only keep its size. */
+      if (new_size + TAG_SIZE > a->desc->block_size)
+        return false;
+    }
+  else
+    {
+      /* A big block can give up or take on whole pages. */
+      page_cnt = DIV_ROUND_UP (new_size + TAG_SIZE + sizeof *a, PGSIZE);
+      if (page_cnt < a->free_cnt)
+        {
+          palloc_free_multiple ((uint8_t *) a + page_cnt * PGSIZE,
+                                a->free_cnt - page_cnt);
+          a->free_cnt = page_cnt;
+        }
+      else if (page_cnt > a->free_cnt)
+        {
+          if (!palloc_extend_multiple (a, a->free_cnt, page_cnt))
+            return false;
+          a->free_cnt = page_cnt;
+        }
+    }
+
+  profile_resize (block, new_size);
+  return true;
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
@@ -199,9 +410,11 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    return old_block;
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = do_malloc (new_size, CALLER);
       if (old_block != NULL && new_block != NULL)
         {
           size_t old_size = block_size (old_block);
@@ -219,48 +432,7 @@ void
 free (void *p) 
 {
   if (p != NULL)
-    {
-      struct block *b = p;
-      struct arena *a = block_to_arena (b);
-      struct desc *d = a->desc;
-      
-      if (d != NULL) 
-        {
-          /* It's a normal block.  We handle it here. */
-
-#ifndef NDEBUG
-          /* Clear the block to help detect use-after-free bugs. */
-          memset (b, 0xcc, d->block_size);
-#endif
-  
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
-
-          lock_release (&d->lock);
-        }
-      else
-        {
-          /* It's a big block.  Free its pages. */
-          palloc_free_multiple (a, a->free_cnt);
-          return;
-        }
-    }
+    free_block (profile_free (p));
 }
 
 /* Returns the arena that block B is inside. */
@@ -292,3 +464,192 @@ arena_to_block (struct arena *a, size_t idx)
                            + sizeof *a
                            + idx * a->desc->block_size);
 }
+
+#ifdef MALLOC_PROFILE
+/* Returns the counters for the size class of raw block B. */
+static struct alloc_stats *
+class_stats (struct block *b)
+{
+  struct desc *d = block_to_arena (b)->desc;
+  return d != NULL ? &desc_stats[d - descs] : &big_stats;
+}
+
+/* Returns the site for return address CALLER, creating it if
+   necessary.  Interrupts must be off. */
+static struct site *
+lookup_site (void *caller)
+{
+  size_t i = ((uintptr_t) caller * 0x9e3779b1u) >> (32 - SITE_BITS);
+  size_t probes;
+
+  for (probes = 0; probes < SITE_CNT; probes++)
+    {
+      struct site *s = &sites[i];
+      if (s->caller == caller)
+        return s;
+      else if (s->caller == NULL)
+        {
+          s->caller = caller;
+          return s;
+        }
+      i = (i + 1) & (SITE_CNT - 1);
+    }
+  return &sites[SITE_CNT];
+}
+
+/* Adds SIZE bytes in CNT blocks to S. */
+static void
+charge (struct alloc_stats *s, int cnt, ptrdiff_t size)
+{
+  if (cnt > 0)
+    s->alloc_cnt++;
+  s->live_cnt += cnt;
+  s->live_bytes += size;
+  if (s->live_bytes > s->peak_bytes)
+    s->peak_bytes = s->live_bytes;
+}
+
+/* Tags raw block B, just allocated for SIZE bytes on behalf of
+   CALLER, and returns the address to hand to the caller. */
+static void *
+profile_alloc (void *b, size_t size, void *caller)
+{
+  struct alloc_tag *t = b;
+  enum intr_level old_level = intr_disable ();
+
+  t->site = lookup_site (caller);
+  t->size = size;
+  charge (&t->site->stats, 1, size);
+  charge (class_stats (b), 1, size);
+
+  intr_set_level (old_level);
+  return t + 1;
+}
+
+/* Uncharges block P, about to be freed, and returns the raw block
+   to free. */
+static void *
+profile_free (void *p)
+{
+  struct alloc_tag *t = raw_block (p);
+  enum intr_level old_level = intr_disable ();
+
+  charge (&t->site->stats, -1, -(ptrdiff_t) t->size);
+  charge (class_stats ((struct block *) t), -1, -(ptrdiff_t) t->size);
+
+  intr_set_level (old_level);
+  return t;
+}
+
+/* Updates the counters for block P, which has been resized in
+   place to SIZE bytes. */
+static void
+profile_resize (void *p, size_t size)
+{
+  struct alloc_tag *t = raw_block (p);
+  ptrdiff_t delta = (ptrdiff_t) size - (ptrdiff_t) t->size;
+  enum intr_level old_level = intr_disable ();
+
+  charge (&t->site->stats, 0, delta);
+  charge (class_stats ((struct block *) t), 0, delta);
+  t->size = size;
+
+  intr_set_level (old_level);
+}
+
+/* Returns the raw block that contains block P. */
+static void *
+raw_block (void *p)
+{
+  return (struct alloc_tag *) p - 1;
+}
+
+/* Returns true if site A should be reported ahead of site B. */
+static bool
+site_before (const struct site *a, const struct site *b)
+{
+  if (a->stats.live_bytes != b->stats.live_bytes)
+    return a->stats.live_bytes > b->stats.live_bytes;
+  return a->stats.peak_bytes > b->stats.peak_bytes;
+}
+
+/* Prints the counters for each size class, how full its arenas
+   are, and the TOP_CNT call sites holding the most memory.  The
+   sites are identified by return address; pass them to the
+   `backtrace' utility to translate them to source lines. */
+void
+malloc_print_profile (size_t top_cnt)
+{
+  enum { TOP_MAX = 32 };
+  struct site top[TOP_MAX];
+  size_t used_cnt, i;
+
+  printf ("Malloc: %6s %8s %7s %10s %10s %6s %5s %5s\n", "class",
+          "allocs", "live", "bytes", "peak", "arenas", "used", "fill");
+  for (i = 0; i < desc_cnt; i++)
+    {
+      struct desc *d = &descs[i];
+      struct alloc_stats s = desc_stats[i];
+      size_t slots = d->arena_cnt * d->blocks_per_arena;
+
+      if (s.alloc_cnt == 0)
+        continue;
+
+      /* "used" is the fraction of blocks in the arenas that are
+         allocated, "fill" the fraction of their bytes that were
+         actually requested. */
+      printf ("Malloc: %6zu %8zu %7zu %10zu %10zu %6zu %4zu%% %4zu%%\n",
+              d->block_size, s.alloc_cnt, s.live_cnt, s.live_bytes,
+              s.peak_bytes, d->arena_cnt,
+              slots != 0 ? s.live_cnt * 100 / slots : 0,
+              slots != 0 ? s.live_bytes * 100 / (slots * d->block_size) : 0);
+    }
+  printf ("Malloc: %6s %8zu %7zu %10zu %10zu\n", "big",
+          big_stats.alloc_cnt, big_stats.live_cnt, big_stats.live_bytes,
+          big_stats.peak_bytes);
+
+  /* Select the top sites by insertion into TOP[], with
+     interrupts off so that the counters are consistent. */
+  if (top_cnt > TOP_MAX)
+    top_cnt = TOP_MAX;
+  used_cnt = 0;
+  {
+    enum intr_level old_level = intr_disable ();
+    for (i = 0; i <= SITE_CNT; i++)
+      {
+        const struct site *s = &sites[i];
+        size_t j;
+
+        if (s->stats.alloc_cnt == 0)
+          continue;
+        for (j = used_cnt; j > 0 && site_before (s, &top[j - 1]); j--)
+          if (j < top_cnt)
+            top[j] = top[j - 1];
+        if (j < top_cnt)
+          {
+            top[j] = *s;
+            if (used_cnt < top_cnt)
+              used_cnt++;
+          }
+      }
+    intr_set_level (old_level);
+  }
+
+  printf ("Malloc: top %zu call sites by live bytes:\n", used_cnt);
+  printf ("Malloc: %10s %8s %7s %10s %10s\n", "caller",
+          "allocs", "live", "bytes", "peak");
+  for (i = 0; i < used_cnt; i++)
+    {
+      const struct site *s = &top[i];
+      char caller[16];
+
+      if (s->caller != NULL)
+        snprintf (caller, sizeof caller, "%p", s->caller);
+      else
+        strlcpy (caller, "(others)", sizeof caller);
+      printf ("Malloc: %10s %8zu %7zu %10zu %10zu\n", caller,
+              s->stats.alloc_cnt, s->stats.live_cnt,
+              s->stats.live_bytes, s->stats.peak_bytes);
+    }
+}
+#endif /* MALLOC_PROFILE */
@@ -10,4 +10,8 @@ void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
 
+#ifdef MALLOC_PROFILE
+void malloc_print_profile (size_t top_cnt);
+#endif
+
 #endif /* threads/malloc.h */
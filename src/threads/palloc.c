@@ -2,13 +2,14 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -25,12 +26,66 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
+/* Each pool is managed as a binary buddy system.  A free block
+   of order K is 2**K pages long and starts at a page index
+   (relative to the pool base) that is a multiple of 2**K.  Its
+   "buddy" is the block of the same order whose index differs only
+   in bit K; when both are free they are merged into one block of
+   order K + 1.  Free blocks are kept on one list per order, linked
+   through a list_elem stored in the first page of each block, so
+   allocation and freeing take O(log n) time.
+
+   Requests for a page count that is not a power of 2 are served
+   from the smallest block that fits and the unused tail is
+   returned to the free lists at once, so multi-page allocations
+   waste no memory.
+
+   palloc_free_page() is called by the scheduler with interrupts
+   off to free a dying thread's page, so the free lists are
+   protected by disabling interrupts rather than by a lock.  The
+   critical sections are short: at most a few list operations per
+   order.
+
+   Single pages, which are by far the most common request, come
+   from a small per-pool cache of free pages in front of the buddy
+   system.  palloc_get_page() and palloc_free_page() usually just
+   pop or push a cache entry.  The cache is refilled from, and
+   drained back to, the buddy system PAGE_CACHE_BATCH pages at a
+   time. */
+
+/* Highest block order.  2**MAX_ORDER pages is more memory than
+   Pintos can address. */
+#define MAX_ORDER 16
+
+/* Per-page state, one byte per page in the pool.  A page inside
+   a free block, other than its first page, has state 0. */
+#define PAGE_FREE_HEAD 0x80             /* First page of a free block. */
+#define PAGE_ALLOCATED 0x40             /* Handed out to a caller. */
+#define PAGE_CACHED 0x20                /* In the pool's page cache. */
+#define PAGE_ORDER_MASK 0x1f            /* Order of a free block. */
+
+/* Capacity of each pool's page cache, and the number of pages
+   moved between the cache and the buddy system at once. */
+#define PAGE_CACHE_SIZE 32
+#define PAGE_CACHE_BATCH 16
+
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    const char *name;                   /* Name, for statistics. */
+    uint8_t *page_state;                /* Per-page state bytes. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    size_t free_cnt;                    /* Number of free pages. */
+    struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+    size_t block_cnt[MAX_ORDER + 1];    /* Length of each free list. */
+
+    /* Page cache. */
+    void *cache[PAGE_CACHE_SIZE];       /* Free pages, most recent last. */
+    size_t cache_cnt;                   /* Number of pages in cache. */
+    long long cache_hit_cnt;            /* # of allocations from cache. */
+    long long cache_refill_cnt;         /* # of refills. */
+    long long cache_drain_cnt;          /* # of drains. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +94,16 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static bool claim_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void refill_cache (struct pool *);
+static void drain_cache (struct pool *, size_t cnt);
+static void set_page_state (struct pool *, size_t page_idx, size_t page_cnt,
+                            uint8_t state);
+static bool page_state_is (const struct pool *, size_t page_idx,
+                           size_t page_cnt, uint8_t state);
+static struct pool *pool_for_page (void *page);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -73,13 +138,22 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
   size_t page_idx;
+  enum intr_level old_level;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  old_level = intr_disable ();
+  page_idx = alloc_pages (pool, page_cnt);
+  if (page_idx == BITMAP_ERROR && pool->cache_cnt > 0)
+    {
+      /* Pages held in the cache might complete a block. */
+      drain_cache (pool, pool->cache_cnt);
+      page_idx = alloc_pages (pool, page_cnt);
+    }
+  if (page_idx != BITMAP_ERROR)
+    set_page_state (pool, page_idx, page_cnt, PAGE_ALLOCATED);
+  intr_set_level (old_level);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -110,7 +184,29 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 void *
 palloc_get_page (enum palloc_flags flags) 
 {
-  return palloc_get_multiple (flags, 1);
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  void *page = NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  if (pool->cache_cnt == 0)
+    refill_cache (pool);
+  if (pool->cache_cnt > 0)
+    {
+      page = pool->cache[--pool->cache_cnt];
+      set_page_state (pool, pg_no (page) - pg_no (pool->base), 1,
+                      PAGE_ALLOCATED);
+      pool->cache_hit_cnt++;
+    }
+  intr_set_level (old_level);
+
+  /* Out of pages: let palloc_get_multiple() handle failure. */
+  if (page == NULL)
+    return palloc_get_multiple (flags, 1);
+
+  if (flags & PAL_ZERO)
+    memset (page, 0, PGSIZE);
+  return page;
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -119,33 +215,84 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
-    pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
-    pool = &user_pool;
-  else
-    NOT_REACHED ();
-
+  pool = pool_for_page (pages);
   page_idx = pg_no (pages) - pg_no (pool->base);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
+  old_level = intr_disable ();
+  ASSERT (page_state_is (pool, page_idx, page_cnt, PAGE_ALLOCATED));
+  free_pages (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
+}
+
+/* Tries to extend the PAGE_CNT pages starting at PAGES, which
+   must have been allocated with palloc_get_multiple(), to
+   NEW_CNT pages by allocating the pages that follow them.
+   Returns true if successful, false if any of those pages is in
+   use or outside the pool. */
+bool
+palloc_extend_multiple (void *pages, size_t page_cnt, size_t new_cnt)
+{
+  struct pool *pool;
+  size_t page_idx;
+  enum intr_level old_level;
+  bool success;
+
+  ASSERT (pg_ofs (pages) == 0);
+  ASSERT (new_cnt >= page_cnt);
+  if (new_cnt == page_cnt)
+    return true;
+
+  pool = pool_for_page (pages);
+  page_idx = pg_no (pages) - pg_no (pool->base);
+  if (new_cnt > pool->page_cnt - page_idx)
+    return false;
+
+  old_level = intr_disable ();
+  success = claim_pages (pool, page_idx + page_cnt, new_cnt - page_cnt);
+  if (success)
+    set_page_state (pool, page_idx + page_cnt, new_cnt - page_cnt,
+                    PAGE_ALLOCATED);
+  intr_set_level (old_level);
+  return success;
 }
 
 /* Frees the page at PAGE. */
 void
 palloc_free_page (void *page) 
 {
-  palloc_free_multiple (page, 1);
+  struct pool *pool;
+  size_t page_idx;
+  enum intr_level old_level;
+
+  ASSERT (pg_ofs (page) == 0);
+  if (page == NULL)
+    return;
+
+  pool = pool_for_page (page);
+  page_idx = pg_no (page) - pg_no (pool->base);
+
+#ifndef NDEBUG
+  memset (page, 0xcc, PGSIZE);
+#endif
+
+  old_level = intr_disable ();
+  ASSERT (page_state_is (pool, page_idx, 1, PAGE_ALLOCATED));
+  if (pool->cache_cnt == PAGE_CACHE_SIZE)
+    drain_cache (pool, PAGE_CACHE_BATCH);
+  set_page_state (pool, page_idx, 1, PAGE_CACHED);
+  pool->cache[pool->cache_cnt++] = page;
+  intr_set_level (old_level);
 }
 
 /* Initializes pool P as starting at START and ending at END,
@@ -153,20 +300,38 @@ palloc_free_page (void *page)
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's page state bytes at its base.
+     Calculate the space needed for them
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t state_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  enum intr_level old_level;
+  int order;
+
+  if (state_pages > page_cnt)
+    PANIC ("Not enough memory in %s for page state.", name);
+  page_cnt -= state_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->name = name;
+  p->page_state = base;
+  p->base = base + state_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  p->free_cnt = 0;
+  for (order = 0; order <= MAX_ORDER; order++)
+    {
+      list_init (&p->free_lists[order]);
+      p->block_cnt[order] = 0;
+    }
+  p->cache_cnt = 0;
+  p->cache_hit_cnt = p->cache_refill_cnt = p->cache_drain_cnt = 0;
+  memset (p->page_state, 0, page_cnt);
+
+  /* Carve the whole pool into free blocks. */
+  old_level = intr_disable ();
+  free_pages (p, 0, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +341,316 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the pool that PAGE belongs to. */
+static struct pool *
+pool_for_page (void *page)
+{
+  if (page_from_pool (&kernel_pool, page))
+    return &kernel_pool;
+  else if (page_from_pool (&user_pool, page))
+    return &user_pool;
+  else
+    NOT_REACHED ();
+}
+
+/* Returns the list element in the first page of POOL's block at
+   PAGE_IDX. */
+static struct list_elem *
+block_elem (const struct pool *pool, size_t page_idx)
+{
+  return (struct list_elem *) (pool->base + page_idx * PGSIZE);
+}
+
+/* Returns the page index of the block whose first page holds
+   list element E. */
+static size_t
+block_idx (const struct pool *pool, struct list_elem *e)
+{
+  return ((uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Sets the state of the PAGE_CNT pages at PAGE_IDX in POOL to
+   STATE. */
+static void
+set_page_state (struct pool *pool, size_t page_idx, size_t page_cnt,
+                uint8_t state)
+{
+  memset (pool->page_state + page_idx, state, page_cnt);
+}
+
+/* Returns true if each of the PAGE_CNT pages at PAGE_IDX in POOL
+   has state STATE, false otherwise. */
+static bool
+page_state_is (const struct pool *pool, size_t page_idx, size_t page_cnt,
+               uint8_t state)
+{
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    if (pool->page_state[page_idx + i] != state)
+      return false;
+  return true;
+}
+
+/* Adds the block of ORDER at PAGE_IDX to POOL's free lists. */
+static void
+push_block (struct pool *pool, size_t page_idx, int order)
+{
+  pool->page_state[page_idx] = PAGE_FREE_HEAD | order;
+  list_push_front (&pool->free_lists[order], block_elem (pool, page_idx));
+  pool->block_cnt[order]++;
+}
+
+/* Removes the free block of ORDER at PAGE_IDX from POOL's free
+   lists. */
+static void
+remove_block (struct pool *pool, size_t page_idx, int order)
+{
+  ASSERT (pool->page_state[page_idx] == (PAGE_FREE_HEAD | order));
+  pool->page_state[page_idx] = 0;
+  list_remove (block_elem (pool, page_idx));
+  pool->block_cnt[order]--;
+}
+
+/* Returns true if the block of ORDER at PAGE_IDX is free in
+   POOL. */
+static bool
+block_is_free (const struct pool *pool, size_t page_idx, int order)
+{
+  return (page_idx + ((size_t) 1 << order) <= pool->page_cnt
+          && pool->page_state[page_idx] == (PAGE_FREE_HEAD | order));
+}
+
+/* Frees the block of ORDER at PAGE_IDX in POOL, merging it with
+   its buddy for as long as the buddy is also free. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order)
+{
+  ASSERT (!(pool->page_state[page_idx] & PAGE_FREE_HEAD));
+
+  for (; order < MAX_ORDER; order++)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+      if (!block_is_free (pool, buddy_idx, order))
+        break;
+      remove_block (pool, buddy_idx, order);
+      if (buddy_idx < page_idx)
+        page_idx = buddy_idx;
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, which need not be
+   a single block: the range is split into the largest aligned
+   blocks that it contains. */
+static void
+free_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  set_page_state (pool, page_idx, page_cnt, 0);
+  pool->free_cnt += page_cnt;
+  while (page_cnt > 0)
+    {
+      int order = 0;
+      while (order < MAX_ORDER
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Returns the order of the free block in POOL that contains page
+   PAGE_IDX, storing the index of its first page into *HEAD_IDX,
+   or returns -1 if PAGE_IDX is not free. */
+static int
+find_free_block (const struct pool *pool, size_t page_idx, size_t *head_idx)
+{
+  int order;
+
+  for (order = 0; order <= MAX_ORDER; order++)
+    {
+      size_t head = page_idx & ~(((size_t) 1 << order) - 1);
+      if (block_is_free (pool, head, order))
+        {
+          *head_idx = head;
+          return order;
+        }
+    }
+  return -1;
+}
+
+/* Allocates the PAGE_CNT pages starting at PAGE_IDX in POOL, if
+   they are all free.  Returns true if successful, false if any
+   of them is in use. */
+static bool
+claim_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  size_t end = page_idx + page_cnt;
+  size_t i, head;
+  int order;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* Check first, so that failure changes nothing. */
+  for (i = page_idx; i < end; i = head + ((size_t) 1 << order))
+    {
+      order = find_free_block (pool, i, &head);
+      if (order < 0)
+        return false;
+    }
+
+  /* Take each free block that overlaps the range, giving back
+     the parts of it outside the range.  Those parts lie within
+     the block taken, so they cannot merge with anything in the
+     range. */
+  for (i = page_idx; i < end; i = head + ((size_t) 1 << order))
+    {
+      size_t block_end;
+
+      order = find_free_block (pool, i, &head);
+      ASSERT (order >= 0);
+      block_end = head + ((size_t) 1 << order);
+      remove_block (pool, head, order);
+      pool->free_cnt -= (size_t) 1 << order;
+      if (head < i)
+        free_pages (pool, head, i - head);
+      if (block_end > end)
+        free_pages (pool, end, block_end - end);
+    }
+  return true;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if no free block is large
+   enough. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt)
+{
+  int want, order;
+  size_t page_idx;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* Smallest order that holds PAGE_CNT pages. */
+  for (want = 0; ((size_t) 1 << want) < page_cnt; want++)
+    if (want == MAX_ORDER)
+      return BITMAP_ERROR;
+
+  /* Smallest free block of at least that order. */
+  for (order = want; order <= MAX_ORDER; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order > MAX_ORDER)
+    return BITMAP_ERROR;
+
+  page_idx = block_idx (pool, list_front (&pool->free_lists[order]));
+  remove_block (pool, page_idx, order);
+
+  /* Split it, returning upper halves to the free lists. */
+  while (order > want)
+    {
+      order--;
+      push_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+
+  /* Give back the pages beyond PAGE_CNT. */
+  pool->free_cnt -= (size_t) 1 << want;
+  if (page_cnt < ((size_t) 1 << want))
+    free_pages (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+
+  return page_idx;
+}
+
+/* Moves up to PAGE_CACHE_BATCH free pages from POOL's buddy
+   system into its empty page cache, as a single block if
+   possible. */
+static void
+refill_cache (struct pool *pool)
+{
+  size_t page_idx;
+  size_t i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (pool->cache_cnt == 0);
+
+  page_idx = alloc_pages (pool, PAGE_CACHE_BATCH);
+  if (page_idx != BITMAP_ERROR)
+    {
+      /* Stack the pages so that the lowest is handed out first. */
+      set_page_state (pool, page_idx, PAGE_CACHE_BATCH, PAGE_CACHED);
+      for (i = PAGE_CACHE_BATCH; i-- > 0; )
+        pool->cache[pool->cache_cnt++] = pool->base + (page_idx + i) * PGSIZE;
+    }
+  else
+    {
+      /* Memory is low or fragmented: take single pages. */
+      while (pool->cache_cnt < PAGE_CACHE_BATCH)
+        {
+          page_idx = alloc_pages (pool, 1);
+          if (page_idx == BITMAP_ERROR)
+            break;
+          set_page_state (pool, page_idx, 1, PAGE_CACHED);
+          pool->cache[pool->cache_cnt++] = pool->base + page_idx * PGSIZE;
+        }
+    }
+  pool->cache_refill_cnt++;
+}
+
+/* Returns the CNT least recently freed pages in POOL's page cache
+   to its buddy system. */
+static void
+drain_cache (struct pool *pool, size_t cnt)
+{
+  size_t i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (cnt <= pool->cache_cnt);
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t page_idx = pg_no (pool->cache[i]) - pg_no (pool->base);
+      ASSERT (page_state_is (pool, page_idx, 1, PAGE_CACHED));
+      free_pages (pool, page_idx, 1);
+    }
+  pool->cache_cnt -= cnt;
+  memmove (pool->cache, pool->cache + cnt,
+           pool->cache_cnt * sizeof *pool->cache);
+  pool->cache_drain_cnt++;
+}
+
+/* Prints POOL's free pages and its free blocks by order. */
+static void
+print_pool_stats (const struct pool *pool)
+{
+  int order, top;
+
+  for (top = MAX_ORDER; top > 0 && pool->block_cnt[top] == 0; top--)
+    continue;
+
+  printf ("Palloc: %s %zu of %zu pages free, free blocks by order:",
+          pool->name, pool->free_cnt + pool->cache_cnt, pool->page_cnt);
+  for (order = 0; order <= top; order++)
+    printf (" %zu", pool->block_cnt[order]);
+  printf ("\n");
+  printf ("Palloc: %s cache %zu pages, %lld hits, %lld refills, "
+          "%lld drains\n", pool->name, pool->cache_cnt,
+          pool->cache_hit_cnt, pool->cache_refill_cnt,
+          pool->cache_drain_cnt);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
@@ -0,0 +1,114 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Sampling profiler.
+
+   When profiling is on, the timer interrupt handler passes each
+   interrupt frame to profile_sample(), which counts the
+   interrupted instruction address, whether in the kernel or in a
+   user program.  Over a long enough run, the number of samples
+   at an address is proportional to the time spent there.
+
+   The counts are kept in a fixed-size open-addressing hash
+   table, so that sampling never allocates memory.  A sample
+   whose address does not fit is counted as dropped.
+
+   At shutdown, profile_print_stats() prints a "Profiler:" line
+   with the total and dropped sample counts, then the counts as
+   lines of the form
+        Profile: COUNT*ADDRESS COUNT*ADDRESS ...
+   Give only the "Profile:" lines to the `backtrace' utility, along with the
+   kernel and any user programs, to get a flat profile by
+   function. */
+
+/* Number of distinct addresses that can be counted. */
+#define SAMPLE_BITS 10
+#define SAMPLE_CNT (1u << SAMPLE_BITS)
+
+/* Maximum number of slots probed for an address. */
+#define MAX_PROBES 16
+
+/* Count of samples at one address. */
+struct sample
+  {
+    uintptr_t eip;              /* Instruction address, 0 if unused. */
+    unsigned cnt;               /* Number of samples. */
+  };
+
+/* If true, sample the running code on every timer tick.
+   Controlled by kernel command-line option "-profile". */
+bool profile_on;
+
+static struct sample samples[SAMPLE_CNT];
+static unsigned sample_cnt;     /* Samples taken. */
+static unsigned dropped_cnt;    /* Samples dropped for lack of room. */
+
+/* Counts a sample of the code interrupted in interrupt frame F.
+   Called from the timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *f)
+{
+  uintptr_t eip = (uintptr_t) f->eip;
+  size_t i = (eip * 0x9e3779b1u) >> (32 - SAMPLE_BITS);
+  int probes;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!profile_on)
+    return;
+
+  sample_cnt++;
+  for (probes = 0; probes < MAX_PROBES; probes++)
+    {
+      struct sample *s = &samples[i];
+      if (s->eip == eip || s->eip == 0)
+        {
+          s->eip = eip;
+          s->cnt++;
+          return;
+        }
+      i = (i + 1) & (SAMPLE_CNT - 1);
+    }
+  dropped_cnt++;
+}
+
+/* Orders samples A_ and B_ for qsort(), most frequent first. */
+static int
+compare_samples (const void *a_, const void *b_)
+{
+  const struct sample *a = a_;
+  const struct sample *b = b_;
+
+  return a->cnt > b->cnt ? -1 : a->cnt < b->cnt;
+}
+
+/* Stops profiling and prints the samples, most frequent first,
+   in a form that the `backtrace' utility can read. */
+void
+profile_print_stats (void)
+{
+  enum intr_level old_level;
+  size_t i;
+
+  if (!profile_on)
+    return;
+
+  old_level = intr_disable ();
+  profile_on = false;
+  intr_set_level (old_level);
+
+  printf ("Profiler: %u samples, %u dropped\n", sample_cnt, dropped_cnt);
+  qsort (samples, SAMPLE_CNT, sizeof *samples, compare_samples);
+  for (i = 0; i < SAMPLE_CNT && samples[i].cnt != 0; i++)
+    {
+      if (i % 4 == 0)
+        printf ("%sProfile:", i > 0 ? "\n" : "");
+      printf (" %u*%#"PRIxPTR, samples[i].cnt, samples[i].eip);
+    }
+  if (i > 0)
+    printf ("\n");
+}
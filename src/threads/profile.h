@@ -0,0 +1,14 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/* If true, sample the running code on every timer tick.
+   Controlled by kernel command-line option "-profile". */
+extern bool profile_on;
+
+void profile_sample (const struct intr_frame *);
+void profile_print_stats (void);
+
+#endif /* threads/profile.h */
@@ -27,11 +27,34 @@
 */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+#ifdef LOCK_STATS
+/* Lock statistics.
+
+   When the kernel is built with LOCK_STATS defined (run "make
+   LOCK_STATS=1"), every lock counts its acquisitions, how many
+   of them had to wait, and how long it was waited for and held,
+   in CPU cycles.  Locks that are given a name with
+   lock_set_name() are also added to a list, so that
+   lock_print_stats() can report the most contended ones.  Only
+   locks that are never destroyed should be named. */
+
+/* Named locks.  Protected by disabling interrupts. */
+static struct list named_locks = LIST_INITIALIZER (named_locks);
+
+/* Maximum number of locks reported by lock_print_stats(). */
+#define REPORT_MAX 20
+
+static void lock_acquired (struct lock *, uint64_t start, bool contended);
+static void lock_releasing (struct lock *);
+#endif
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -179,6 +202,12 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+#ifdef LOCK_STATS
+  lock->name = NULL;
+  lock->acquire_cnt = lock->contended_cnt = 0;
+  lock->wait_cycles = lock->max_wait_cycles = 0;
+  lock->hold_cycles = lock->max_hold_cycles = 0;
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -196,7 +225,17 @@ lock_acquire (struct lock *lock)
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+#ifdef LOCK_STATS
+  {
+    uint64_t start = rdtsc ();
+    bool contended = !sema_try_down (&lock->semaphore);
+    if (contended)
+      sema_down (&lock->semaphore);
+    lock_acquired (lock, start, contended);
+  }
+#else
   sema_down (&lock->semaphore);
+#endif
   lock->holder = thread_current ();
 }
 
@@ -216,7 +255,12 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+#ifdef LOCK_STATS
+      lock_acquired (lock, rdtsc (), false);
+#endif
+      lock->holder = thread_current ();
+    }
   return success;
 }
 
@@ -231,6 +275,9 @@ lock_release (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+#ifdef LOCK_STATS
+  lock_releasing (lock);
+#endif
   lock->holder = NULL;
   sema_up (&lock->semaphore);
 }
@@ -336,3 +383,96 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+#ifdef LOCK_STATS
+/* Names LOCK as NAME in lock_print_stats()'s report. */
+void
+lock_set_name (struct lock *lock, const char *name) 
+{
+  enum intr_level old_level;
+
+  ASSERT (lock != NULL);
+  ASSERT (name != NULL);
+  ASSERT (lock->name == NULL);
+
+  lock->name = name;
+  old_level = intr_disable ();
+  list_push_back (&named_locks, &lock->elem);
+  intr_set_level (old_level);
+}
+
+/* Updates LOCK's statistics after the current thread acquires
+   it, having started to try at time START.  CONTENDED is true if
+   it had to wait. */
+static void
+lock_acquired (struct lock *lock, uint64_t start, bool contended) 
+{
+  uint64_t now = rdtsc ();
+
+  lock->acquire_cnt++;
+  if (contended)
+    {
+      uint64_t wait = now - start;
+      lock->contended_cnt++;
+      lock->wait_cycles += wait;
+      if (wait > lock->max_wait_cycles)
+        lock->max_wait_cycles = wait;
+    }
+  lock->acquire_time = now;
+}
+
+/* Updates LOCK's statistics as the current thread releases it. */
+static void
+lock_releasing (struct lock *lock) 
+{
+  uint64_t hold = rdtsc () - lock->acquire_time;
+
+  lock->hold_cycles += hold;
+  if (hold > lock->max_hold_cycles)
+    lock->max_hold_cycles = hold;
+}
+
+/* Returns true if lock A has been waited for longer than lock
+   B. */
+static bool
+more_contended (const struct list_elem *a_, const struct list_elem *b_,
+                void *aux UNUSED) 
+{
+  const struct lock *a = list_entry (a_, struct lock, elem);
+  const struct lock *b = list_entry (b_, struct lock, elem);
+
+  if (a->wait_cycles != b->wait_cycles)
+    return a->wait_cycles > b->wait_cycles;
+  return a->contended_cnt > b->contended_cnt;
+}
+
+/* Prints statistics for the named locks that have been waited
+   for the longest. */
+void
+lock_print_stats (void) 
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+  int i;
+
+  old_level = intr_disable ();
+  list_sort (&named_locks, more_contended, NULL);
+  intr_set_level (old_level);
+
+  printf ("Locks: %-12s %9s %9s %12s %12s %12s %12s\n", "name",
+          "acquires", "contended", "wait cycles", "max wait",
+          "hold cycles", "max hold");
+  for (e = list_begin (&named_locks), i = 0;
+       e != list_end (&named_locks) && i < REPORT_MAX;
+       e = list_next (e), i++)
+    {
+      struct lock *l = list_entry (e, struct lock, elem);
+      if (l->acquire_cnt == 0)
+        break;
+      printf ("Locks: %-12s %9u %9u %12"PRIu64" %12"PRIu64
+              " %12"PRIu64" %12"PRIu64"\n",
+              l->name, l->acquire_cnt, l->contended_cnt, l->wait_cycles,
+              l->max_wait_cycles, l->hold_cycles, l->max_hold_cycles);
+    }
+}
+#endif /* LOCK_STATS */
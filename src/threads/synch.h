@@ -1,8 +1,10 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <debug.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
@@ -22,6 +24,19 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+#ifdef LOCK_STATS
+    /* Contention statistics, in CPU cycles.  Protected by the
+       lock itself. */
+    const char *name;           /* Name given by lock_set_name(). */
+    struct list_elem elem;      /* Element in list of named locks. */
+    unsigned acquire_cnt;       /* Number of acquisitions. */
+    unsigned contended_cnt;     /* Acquisitions that had to wait. */
+    uint64_t wait_cycles;       /* Total time spent waiting. */
+    uint64_t max_wait_cycles;   /* Longest wait. */
+    uint64_t hold_cycles;       /* Total time held. */
+    uint64_t max_hold_cycles;   /* Longest hold. */
+    uint64_t acquire_time;      /* When last acquired. */
+#endif
   };
 
 void lock_init (struct lock *);
@@ -30,6 +45,18 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+#ifdef LOCK_STATS
+void lock_set_name (struct lock *, const char *name);
+void lock_print_stats (void);
+#else
+/* Names LOCK for the lock statistics, which are only kept when
+   the kernel is built with LOCK_STATS defined. */
+static inline void
+lock_set_name (struct lock *lock UNUSED, const char *name UNUSED) 
+{
+}
+#endif
+
 /* Condition variable. */
 struct condition 
   {
@@ -10,6 +10,7 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -90,6 +91,7 @@ thread_init (void)
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
+  lock_set_name (&tid_lock, "tid");
   list_init (&ready_list);
   list_init (&all_list);
 
@@ -239,6 +241,7 @@ thread_unblock (struct thread *t)
   ASSERT (t->status == THREAD_BLOCKED);
   list_push_back (&ready_list, &t->elem);
   t->status = THREAD_READY;
+  trace_event (TRACE_WAKEUP, t->tid, 0);
   intr_set_level (old_level);
 }
 
@@ -462,6 +465,11 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+#ifdef USERPROG
+  list_init (&t->children);
+  list_init (&t->fds);
+  t->next_handle = 2;
+#endif
   t->magic = THREAD_MAGIC;
 
   old_level = intr_disable ();
@@ -521,6 +529,8 @@ thread_schedule_tail (struct thread *prev)
 
   /* Mark us as running. */
   cur->status = THREAD_RUNNING;
+  if (prev != NULL)
+    trace_event (TRACE_SWITCH, prev->tid, prev->status);
 
   /* Start new time slice. */
   thread_ticks = 0;
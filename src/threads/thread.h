@@ -96,6 +96,26 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct wait_status *wait_status;    /* This process's completion state. */
+    struct list children;               /* Completion state of children. */
+    uint8_t *heap_start;                /* Start of heap. */
+    uint8_t *brk;                       /* Program break (end of heap). */
+
+    /* Owned by userprog/syscall.c. */
+    struct list fds;                    /* Open file descriptors. */
+    int next_handle;                    /* Next handle value. */
+#ifdef VM
+    struct file *bin_file;              /* The binary executable. */
+
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Page table. */
+    unsigned minor_faults;              /* Faults needing no I/O. */
+    unsigned file_faults;               /* Faults read from a file. */
+    unsigned swap_faults;               /* Faults read from swap. */
+    unsigned evictions;                 /* Pages evicted. */
+    unsigned rss;                       /* Resident pages. */
+    unsigned peak_rss;                  /* Maximum of rss. */
+#endif
 #endif
 
     /* Owned by thread.c. */
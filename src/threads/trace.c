@@ -0,0 +1,119 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Event trace.
+
+   When the kernel is run with -trace, events such as context
+   switches, system calls, page faults, and block requests are
+   appended to a ring buffer of fixed-size binary records, which
+   overwrites the oldest records when it is full.  Recording an
+   event claims a slot with a single atomic increment and fills
+   it in, so it takes no lock, never blocks, and may be done in
+   any context, including interrupt handlers and the middle of a
+   thread switch.
+
+   At shutdown, trace_dump() writes the records, oldest first, to
+   the console as lines of hex.  utils/pintos-trace decodes them
+   into a timeline. */
+
+/* True if events are being recorded. */
+bool trace_on;
+
+static struct trace_record *records;    /* Ring buffer. */
+static uint32_t record_mask;            /* Number of records, minus 1. */
+static uint32_t next_record;            /* Total records ever claimed. */
+
+/* When tracing started, for calibrating the time-stamp counter. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+/* Starts tracing into a ring buffer of PAGE_CNT pages. */
+void
+trace_init (size_t page_cnt)
+{
+  size_t record_cnt;
+
+  records = palloc_get_multiple (0, page_cnt);
+  if (records == NULL)
+    {
+      printf ("trace: could not allocate %zu pages, tracing disabled\n",
+              page_cnt);
+      return;
+    }
+
+  /* Use the largest power of 2 number of records that fits,
+     so that a slot index can be reduced with a mask. */
+  record_cnt = page_cnt * PGSIZE / sizeof *records;
+  while ((record_cnt & (record_cnt - 1)) != 0)
+    record_cnt &= record_cnt - 1;
+  record_mask = record_cnt - 1;
+
+  start_tsc = rdtsc ();
+  start_ticks = timer_ticks ();
+  trace_on = true;
+}
+
+/* Returns the running thread's tid.  Like running_thread() in
+   thread.c, but without its sanity checks, because events are
+   recorded from the middle of thread switches. */
+static tid_t
+running_tid (void)
+{
+  uint32_t *esp;
+  asm ("mov %%esp, %0" : "=g" (esp));
+  return ((struct thread *) pg_round_down (esp))->tid;
+}
+
+/* Records EVENT with arguments ARG0 and ARG1. */
+void
+trace_record (enum trace_event event, uint32_t arg0, uint32_t arg1)
+{
+  uint32_t idx = __sync_fetch_and_add (&next_record, 1);
+  struct trace_record *r = &records[idx & record_mask];
+
+  r->time = rdtsc ();
+  r->event = event;
+  r->tid = running_tid ();
+  r->arg0 = arg0;
+  r->arg1 = arg1;
+}
+
+/* Stops tracing and prints the records, along with the rate of
+   the time-stamp counter, measured against the timer. */
+void
+trace_dump (void)
+{
+  int64_t ticks;
+  uint64_t hz;
+  uint32_t first, idx;
+
+  if (!trace_on)
+    return;
+  trace_on = false;
+
+  ticks = timer_ticks () - start_ticks;
+  hz = ticks > 0 ? (rdtsc () - start_tsc) * TIMER_FREQ / ticks : 0;
+  first = next_record > record_mask ? next_record - record_mask - 1 : 0;
+
+  printf ("Trace: %"PRIu32" records, %"PRIu32" overwritten, "
+          "%"PRIu64" Hz\n", next_record - first, first, hz);
+  for (idx = first; idx != next_record; idx++)
+    {
+      const uint8_t *p = (const uint8_t *) &records[idx & record_mask];
+      char hex[sizeof *records * 2 + 1];
+      size_t i;
+
+      for (i = 0; i < sizeof *records; i++)
+        snprintf (hex + i * 2, 3, "%02x", p[i]);
+      printf ("Trace: %s\n", hex);
+    }
+  printf ("Trace: end\n");
+}
@@ -0,0 +1,50 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Kind of event.  utils/pintos-trace must agree on these
+   values. */
+enum trace_event
+  {
+    TRACE_SWITCH = 1,           /* Switched to this thread from thread
+                                   ARG0, which is left in state ARG1. */
+    TRACE_WAKEUP,               /* Unblocked thread ARG0. */
+    TRACE_SYSCALL,              /* System call number ARG0, with first
+                                   argument ARG1. */
+    TRACE_PAGE_FAULT,           /* Fault at address ARG0, error code ARG1. */
+    TRACE_BLOCK_READ,           /* Reading ARG1 sectors from sector ARG0. */
+    TRACE_BLOCK_WRITE,          /* Writing ARG1 sectors to sector ARG0. */
+    TRACE_BLOCK_DONE            /* Finished a request for ARG1 sectors
+                                   at sector ARG0. */
+  };
+
+/* An event.  Records are dumped as raw bytes, so the layout is
+   part of the format read by utils/pintos-trace. */
+struct trace_record
+  {
+    uint64_t time;              /* Time-stamp counter. */
+    uint16_t event;             /* A TRACE_* value. */
+    uint16_t tid;               /* Running thread. */
+    uint32_t arg0, arg1;        /* Event-specific arguments. */
+  };
+
+/* True if events are being recorded. */
+extern bool trace_on;
+
+void trace_init (size_t page_cnt);
+void trace_record (enum trace_event, uint32_t arg0, uint32_t arg1);
+void trace_dump (void);
+
+/* Records EVENT with arguments ARG0 and ARG1, if tracing is on.
+   When it is off, this costs only a test and a branch. */
+static inline void
+trace_event (enum trace_event event, uint32_t arg0, uint32_t arg1)
+{
+  if (trace_on)
+    trace_record (event, arg0, arg1);
+}
+
+#endif /* threads/trace.h */
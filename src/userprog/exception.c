@@ -2,8 +2,15 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -92,6 +99,16 @@ kill (struct intr_frame *f)
       thread_exit (); 
 
     case SEL_KCSEG:
+      /* SYSENTER does not clear the trap flag, so a user process
+         that single-steps through it traps before the first
+         instruction of the kernel's entry code.  Clear the flag
+         and carry on with the system call. */
+      if (f->vec_no == 1 && f->eip == syscall_sysenter_entry)
+        {
+          f->eflags &= ~FLAG_TF;
+          return;
+        }
+
       /* Kernel's code segment, which indicates a kernel bug.
          Kernel code shouldn't throw exceptions.  (Page faults
          may cause kernel exceptions--but they shouldn't arrive
@@ -135,6 +152,7 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  trace_event (TRACE_PAGE_FAULT, (uintptr_t) fault_addr, f->error_code);
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -148,6 +166,22 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* Let the supplemental page table bring in the page. */
+  if (not_present && page_in (fault_addr))
+    return;
+#endif
+
+  /* A fault in the kernel on a user address comes from get_user()
+     in userprog/syscall.c, which left the address to resume at
+     in EAX.  Resume there with EAX set to 0 to report failure. */
+  if (!user && is_user_vaddr (fault_addr))
+    {
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0;
+      return;
+    }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
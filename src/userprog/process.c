@@ -7,6 +7,7 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
@@ -14,43 +15,72 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Space reserved for the stack at the top of user virtual
+   memory.  The heap may not grow into it. */
+#define STACK_MAX (8 * 1024 * 1024)
 
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
+/* Data structure shared between process_execute() in the
+   invoking thread and start_process() in the newly invoked
+   thread. */
+struct exec_info 
+  {
+    const char *file_name;              /* Program to load. */
+    struct semaphore load_done;         /* "Up"ed when loading complete. */
+    struct wait_status *wait_status;    /* Child process. */
+    bool success;                       /* Program successfully loaded? */
+  };
+
 /* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+   FILE_NAME, which may be followed by arguments separated by
+   spaces.  Returns the new process's thread id, or TID_ERROR if
+   the thread cannot be created or the program cannot be
+   loaded. */
 tid_t
 process_execute (const char *file_name) 
 {
-  char *fn_copy;
+  struct exec_info exec;
+  char thread_name[16];
+  char *save_ptr;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
-    return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
-
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
-  if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+  /* Initialize exec_info. */
+  exec.file_name = file_name;
+  sema_init (&exec.load_done, 0);
+
+  /* Create a new thread to execute FILE_NAME, and wait for it
+     to load, so that FILE_NAME stays valid throughout. */
+  strlcpy (thread_name, file_name, sizeof thread_name);
+  strtok_r (thread_name, " ", &save_ptr);
+  tid = thread_create (thread_name, PRI_DEFAULT, start_process, &exec);
+  if (tid != TID_ERROR)
+    {
+      sema_down (&exec.load_done);
+      if (exec.success)
+        list_push_back (&thread_current ()->children,
+                        &exec.wait_status->elem);
+      else
+        tid = TID_ERROR;
+    }
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *exec_)
 {
-  char *file_name = file_name_;
+  struct exec_info *exec = exec_;
   struct intr_frame if_;
   bool success;
 
@@ -59,10 +89,30 @@ start_process (void *file_name_)
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = load (exec->file_name, &if_.eip, &if_.esp);
+
+  /* Allocate wait_status. */
+  if (success)
+    {
+      exec->wait_status = thread_current ()->wait_status
+        = malloc (sizeof *exec->wait_status);
+      success = exec->wait_status != NULL; 
+    }
 
-  /* If load failed, quit. */
-  palloc_free_page (file_name);
+  /* Initialize wait_status. */
+  if (success) 
+    {
+      struct wait_status *ws = exec->wait_status;
+      lock_init (&ws->lock);
+      ws->ref_cnt = 2;
+      ws->tid = thread_current ()->tid;
+      ws->exit_code = -1;
+      sema_init (&ws->dead, 0);
+    }
+  
+  /* Notify parent thread and clean up. */
+  exec->success = success;
+  sema_up (&exec->load_done);
   if (!success) 
     thread_exit ();
 
@@ -76,18 +126,47 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+/* Releases one reference to CS and, if it is now unreferenced,
+   frees it. */
+static void
+release_child (struct wait_status *cs) 
+{
+  int new_ref_cnt;
+  
+  lock_acquire (&cs->lock);
+  new_ref_cnt = --cs->ref_cnt;
+  lock_release (&cs->lock);
+
+  if (new_ref_cnt == 0)
+    free (cs);
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e)) 
+    {
+      struct wait_status *cs = list_entry (e, struct wait_status, elem);
+      if (cs->tid == child_tid) 
+        {
+          int exit_code;
+          list_remove (e);
+          sema_down (&cs->dead);
+          exit_code = cs->exit_code;
+          release_child (cs);
+          return exit_code;
+        }
+    }
   return -1;
 }
 
@@ -96,8 +175,45 @@ void
 process_exit (void)
 {
   struct thread *cur = thread_current ();
+  struct list_elem *e, *next;
   uint32_t *pd;
 
+  /* Close open files. */
+  syscall_exit ();
+
+  /* Notify parent that we're dead. */
+  if (cur->wait_status != NULL) 
+    {
+      struct wait_status *cs = cur->wait_status;
+      printf ("%s: exit(%d)\n", cur->name, cs->exit_code);
+#ifdef VM
+      if (page_stats_on_exit && cur->pages != NULL)
+        page_print_stats ();
+#endif
+      sema_up (&cs->dead);
+      release_child (cs);
+    }
+
+  /* Free entries of children list. */
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = next) 
+    {
+      struct wait_status *cs = list_entry (e, struct wait_status, elem);
+      next = list_remove (e);
+      release_child (cs);
+    }
+
+#ifdef VM
+  /* Release the process's frames and swap slots.  This must
+     happen before its page directory is destroyed, because the
+     pager may be evicting one of its pages right now. */
+  page_exit ();
+  lock_acquire (&filesys_lock);
+  file_close (cur->bin_file);
+  lock_release (&filesys_lock);
+  cur->bin_file = NULL;
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -195,33 +311,49 @@ struct Elf32_Phdr
 #define PF_W 2          /* Writable. */
 #define PF_R 4          /* Readable. */
 
-static bool setup_stack (void **esp);
+static bool setup_stack (const char *cmd_line, void **esp);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
+/* Loads an ELF executable from the first word of CMD_LINE into
+   the current thread, passing it the words of CMD_LINE as
+   arguments.  Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
    Returns true if successful, false otherwise. */
-bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+static bool
+load (const char *cmd_line, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
+  char file_name[NAME_MAX + 2];
   struct Elf32_Ehdr ehdr;
   struct file *file = NULL;
+  uintptr_t data_end = 0;
   off_t file_ofs;
   bool success = false;
+  char *save_ptr;
   int i;
 
+  /* Extract file name. */
+  strlcpy (file_name, cmd_line, sizeof file_name);
+  strtok_r (file_name, " ", &save_ptr);
+
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
   process_activate ();
+#ifdef VM
+  t->pages = page_table_create ();
+  if (t->pages == NULL)
+    goto done;
+#endif
 
-  /* Open executable file. */
+  /* Open executable file.  The file system lock is held while
+     the headers and segments are read, but not while the stack
+     is set up, which may have to wait for a free frame. */
+  lock_acquire (&filesys_lock);
   file = filesys_open (file_name);
   if (file == NULL) 
     {
@@ -294,6 +426,8 @@ load (const char *file_name, void (**eip) (void), void **esp)
               if (!load_segment (file, file_page, (void *) mem_page,
                                  read_bytes, zero_bytes, writable))
                 goto done;
+              if (phdr.p_vaddr + phdr.p_memsz > data_end)
+                data_end = phdr.p_vaddr + phdr.p_memsz;
             }
           else
             goto done;
@@ -301,8 +435,13 @@ load (const char *file_name, void (**eip) (void), void **esp)
         }
     }
 
+  lock_release (&filesys_lock);
+
+  /* The heap starts empty, on the page after the last segment. */
+  t->heap_start = t->brk = (uint8_t *) ROUND_UP (data_end, PGSIZE);
+
   /* Set up stack. */
-  if (!setup_stack (esp))
+  if (!setup_stack (cmd_line, esp))
     goto done;
 
   /* Start address. */
@@ -312,13 +451,28 @@ load (const char *file_name, void (**eip) (void), void **esp)
 
  done:
   /* We arrive here whether the load is successful or not. */
-  file_close (file);
+#ifdef VM
+  /* Pages are read in from the executable on demand, so keep it
+     open as long as the process runs. */
+  if (success)
+    t->bin_file = file;
+  else
+#endif
+    {
+      if (!lock_held_by_current_thread (&filesys_lock))
+        lock_acquire (&filesys_lock);
+      file_close (file);
+    }
+  if (lock_held_by_current_thread (&filesys_lock))
+    lock_release (&filesys_lock);
   return success;
 }
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -378,7 +532,10 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    user process if WRITABLE is true, read-only otherwise.
 
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   or disk read error occurs.
+
+   With VM, the pages are only entered into the supplemental page
+   table here and are read in from FILE when first touched. */
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
@@ -387,6 +544,27 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      struct page *p = page_allocate (upage, !writable);
+      if (p == NULL)
+        return false;
+      if (page_read_bytes > 0) 
+        {
+          p->file = file;
+          p->file_offset = ofs;
+          p->file_bytes = page_read_bytes;
+        }
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -422,28 +600,113 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       upage += PGSIZE;
     }
   return true;
+#endif
+}
+
+/* Pushes the SIZE bytes in BUF onto the stack whose top is *ESP,
+   which must lie in the stack page.  Returns a pointer to the
+   copy, or a null pointer if the stack page would overflow. */
+static void *
+push (uint8_t **esp, const void *buf, size_t size) 
+{
+  size_t padsize = ROUND_UP (size, sizeof (uint32_t));
+  if ((size_t) (*esp - ((uint8_t *) PHYS_BASE - PGSIZE)) < padsize)
+    return NULL;
+
+  *esp -= padsize;
+  memcpy (*esp + (padsize - size), buf, size);
+  return *esp + (padsize - size);
+}
+
+/* Reverses the order of the CNT pointers in ARRAY. */
+static void
+reverse (int cnt, char **array) 
+{
+  for (; cnt > 1; cnt -= 2, array++) 
+    {
+      char *tmp = array[0];
+      array[0] = array[cnt - 1];
+      array[cnt - 1] = tmp;
+    }
+}
+
+/* Sets up command line arguments on the user stack, whose top is
+   *ESP, in the form expected by _start() in lib/user/entry.c:
+   the argument strings, a null-terminated argv[], a pointer to
+   argv[], argc, and a fake return address.  The stack page must
+   be mapped in the active page directory.  Returns true if
+   successful, false if the arguments do not fit in one page. */
+static bool
+init_cmd_line (uint8_t **esp, const char *cmd_line) 
+{
+  const void *null = NULL;
+  char *cmd_line_copy;
+  char *karg, *saveptr;
+  int argc;
+  char **argv;
+
+  /* Push command line string. */
+  cmd_line_copy = push (esp, cmd_line, strlen (cmd_line) + 1);
+  if (cmd_line_copy == NULL)
+    return false;
+
+  if (push (esp, &null, sizeof null) == NULL)
+    return false;
+
+  /* Parse command line into arguments
+     and push them in reverse order. */
+  argc = 0;
+  for (karg = strtok_r (cmd_line_copy, " ", &saveptr); karg != NULL;
+       karg = strtok_r (NULL, " ", &saveptr))
+    {
+      if (push (esp, &karg, sizeof karg) == NULL)
+        return false;
+      argc++;
+    }
+
+  /* Reverse the order of the command line arguments. */
+  argv = (char **) *esp;
+  reverse (argc, argv);
+
+  /* Push argv, argc, "return address". */
+  if (push (esp, &argv, sizeof argv) == NULL
+      || push (esp, &argc, sizeof argc) == NULL
+      || push (esp, &null, sizeof null) == NULL)
+    return false;
+
+  return true;
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+   user virtual memory, and push the arguments in CMD_LINE on
+   it. */
 static bool
-setup_stack (void **esp) 
+setup_stack (const char *cmd_line, void **esp) 
 {
-  uint8_t *kpage;
-  bool success = false;
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  uint8_t *top = PHYS_BASE;
 
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if (kpage != NULL) 
+#ifdef VM
+  if (page_allocate (upage, false) == NULL)
+    return false;
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page (upage, kpage, true))
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else
-        palloc_free_page (kpage);
+      palloc_free_page (kpage);
+      return false;
     }
-  return success;
+#endif
+
+  if (!init_cmd_line (&top, cmd_line))
+    return false;
+  *esp = top;
+  return true;
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +726,80 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
+
+/* Maps a zeroed page at user virtual address UPAGE into the
+   current process for use as heap.  Returns true if successful,
+   false if memory is exhausted. */
+static bool
+heap_page_alloc (void *upage) 
+{
+#ifdef VM
+  return page_allocate (upage, false) != NULL;
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page (upage, kpage, true))
+    {
+      palloc_free_page (kpage);
+      return false;
+    }
+  return true;
+#endif
+}
+
+/* Unmaps and frees the heap page at user virtual address UPAGE
+   in the current process. */
+static void
+heap_page_free (void *upage) 
+{
+#ifdef VM
+  page_deallocate (upage);
+#else
+  struct thread *t = thread_current ();
+  void *kpage = pagedir_get_page (t->pagedir, upage);
+  ASSERT (kpage != NULL);
+  pagedir_clear_page (t->pagedir, upage);
+  palloc_free_page (kpage);
+#endif
+}
+
+/* Moves the current process's program break, the end of its
+   heap, by INCREMENT bytes, mapping or unmapping whole pages as
+   needed.  Returns the previous break, or (void *) -1 if the
+   heap would shrink below its start, grow into the space
+   reserved for the stack, or memory is exhausted, in which case
+   the break is unchanged. */
+void *
+process_sbrk (intptr_t increment) 
+{
+  struct thread *t = thread_current ();
+  uint8_t *old_brk = t->brk;
+  uint8_t *new_brk = old_brk + increment;
+  uint8_t *old_end = (uint8_t *) pg_round_up (old_brk);
+  uint8_t *new_end = (uint8_t *) pg_round_up (new_brk);
+  uint8_t *upage;
+
+  if (increment < 0
+      ? new_brk < t->heap_start || new_brk > old_brk
+      : new_brk < old_brk || new_brk > (uint8_t *) PHYS_BASE - STACK_MAX)
+    return (void *) -1;
+
+  if (new_end > old_end) 
+    {
+      for (upage = old_end; upage < new_end; upage += PGSIZE)
+        if (!heap_page_alloc (upage)) 
+          {
+            while (upage > old_end)
+              heap_page_free (upage -= PGSIZE);
+            return (void *) -1;
+          }
+    }
+  else
+    for (upage = new_end; upage < old_end; upage += PGSIZE)
+      heap_page_free (upage);
+
+  t->brk = new_brk;
+  return old_brk;
+}
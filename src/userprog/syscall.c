@@ -1,20 +1,949 @@
 #include "userprog/syscall.h"
+#include <iovec.h>
+#include <limits.h>
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <sysring.h>
+#include "userprog/process.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
+#include "userprog/tss.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Maximum number of user pages that read and write pin at once.
+   Larger transfers are done a window of this many pages at a
+   time, so that a single call cannot lock down enough frames to
+   starve the pager. */
+#define PIN_PAGES 16
+
+/* Size of the kernel buffer used by copy_range, in pages. */
+#define COPY_PAGES 4
+
+/* Maximum size of the kernel buffer that readv and writev gather
+   into or scatter from, in pages. */
+#define VECTOR_PAGES 16
 
 static void syscall_handler (struct intr_frame *);
 
+static int sys_halt (void);
+static int sys_exit (int status);
+static int sys_exec (const char *ufile);
+static int sys_wait (tid_t);
+static int sys_create (const char *ufile, unsigned initial_size);
+static int sys_remove (const char *ufile);
+static int sys_open (const char *ufile);
+static int sys_filesize (int handle);
+static int sys_read (int handle, void *udst, unsigned size);
+static int sys_write (int handle, void *usrc, unsigned size);
+static int sys_seek (int handle, unsigned position);
+static int sys_tell (int handle);
+static int sys_close (int handle);
+static int sys_sbrk (intptr_t increment);
+static int sys_readv (int handle, const struct iovec *, int iovcnt);
+static int sys_writev (int handle, const struct iovec *, int iovcnt);
+static int sys_pread (int handle, void *udst, unsigned size,
+                      unsigned position);
+static int sys_pwrite (int handle, void *usrc, unsigned size,
+                       unsigned position);
+static int sys_copy_range (int in_handle, int out_handle, unsigned size);
+static int sys_ring_submit (struct sys_ring *);
+static int sys_sysenter (void);
+
+int syscall_sysenter_handler (unsigned call_nr, int arg0, int arg1,
+                              int arg2, int arg3);
+
+/* If true, user processes may enter system calls with SYSENTER
+   as well as "int $0x30".  Cleared by syscall_init() if the CPU
+   does not support SYSENTER. */
+bool syscall_sysenter = true;
+
+static bool sysenter_supported (void);
+
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+
+  if (syscall_sysenter && sysenter_supported ())
+    {
+      wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+      wrmsr (MSR_SYSENTER_EIP, (uintptr_t) syscall_sysenter_entry);
+      tss_enable_sysenter ();
+    }
+  else
+    syscall_sysenter = false;
+}
+
+/* Returns true if the CPU supports SYSENTER and SYSEXIT. */
+static bool
+sysenter_supported (void)
+{
+  uint32_t regs[4];
+  unsigned family, model, stepping;
+
+  cpuid (0, regs);
+  if (regs[0] < 1)
+    return false;
+  cpuid (1, regs);
+  if ((regs[3] & CPUID_SEP) == 0)
+    return false;
+
+  /* Early Pentium Pro processors report SEP but do not implement
+     it.  See [IA32-v2a] "CPUID". */
+  family = (regs[0] >> 8) & 0xf;
+  model = (regs[0] >> 4) & 0xf;
+  stepping = regs[0] & 0xf;
+  return !(family == 6 && model < 3 && stepping < 3);
+}
+
+/* System call handler.  Each implementation takes between 0
+   and 4 int-sized arguments; extra arguments are ignored. */
+typedef int syscall_function (int, int, int, int);
+
+/* A system call. */
+struct syscall
+  {
+    size_t arg_cnt;           /* Number of arguments. */
+    void *func;               /* Implementation. */
+    bool batchable;           /* May be queued in a sys_ring? */
+  };
+
+/* Table of system calls, indexed by system call number.
+   Calls without an entry are not implemented. */
+static const struct syscall syscall_table[] =
+  {
+    [SYS_HALT] = {0, sys_halt, false},
+    [SYS_EXIT] = {1, sys_exit, false},
+    [SYS_EXEC] = {1, sys_exec, false},
+    [SYS_WAIT] = {1, sys_wait, false},
+    [SYS_CREATE] = {2, sys_create, true},
+    [SYS_REMOVE] = {1, sys_remove, true},
+    [SYS_OPEN] = {1, sys_open, true},
+    [SYS_FILESIZE] = {1, sys_filesize, true},
+    [SYS_READ] = {3, sys_read, true},
+    [SYS_WRITE] = {3, sys_write, true},
+    [SYS_SEEK] = {2, sys_seek, true},
+    [SYS_TELL] = {1, sys_tell, true},
+    [SYS_CLOSE] = {1, sys_close, true},
+    [SYS_SBRK] = {1, sys_sbrk, true},
+    [SYS_READV] = {3, sys_readv, true},
+    [SYS_WRITEV] = {3, sys_writev, true},
+    [SYS_PREAD] = {4, sys_pread, true},
+    [SYS_PWRITE] = {4, sys_pwrite, true},
+    [SYS_COPY_RANGE] = {3, sys_copy_range, true},
+    [SYS_RING_SUBMIT] = {1, sys_ring_submit, false},
+    [SYS_SYSENTER] = {0, sys_sysenter, true},
+  };
+
+static void copy_in (void *, const void *, size_t);
+static void copy_out (void *, const void *, size_t);
+
+/* Returns the system call numbered CALL_NR.
+   Terminates the process if there is no such call. */
+static const struct syscall *
+lookup_syscall (unsigned call_nr)
+{
+  if (call_nr >= sizeof syscall_table / sizeof *syscall_table
+      || syscall_table[call_nr].func == NULL)
+    thread_exit ();
+  return syscall_table + call_nr;
+}
+
+/* System call handler. */
+static void
+syscall_handler (struct intr_frame *f)
+{
+  const struct syscall *sc;
+  unsigned call_nr;
+  int args[4];
+
+  /* Get the system call. */
+  copy_in (&call_nr, f->esp, sizeof call_nr);
+  sc = lookup_syscall (call_nr);
+
+  /* Get the system call arguments. */
+  ASSERT (sc->arg_cnt <= sizeof args / sizeof *args);
+  memset (args, 0, sizeof args);
+  copy_in (args, (uint32_t *) f->esp + 1, sizeof *args * sc->arg_cnt);
+  trace_event (TRACE_SYSCALL, call_nr, args[0]);
+
+  /* Execute the system call,
+     and set the return value. */
+  f->eax = ((syscall_function *) sc->func) (args[0], args[1], args[2],
+                                            args[3]);
 }
 
+/* System call handler for SYSENTER, called by
+   syscall_sysenter_entry in syscall-entry.S with the call number
+   and arguments that the user process passed in registers.
+   Returns the call's return value. */
+int
+syscall_sysenter_handler (unsigned call_nr, int arg0, int arg1, int arg2,
+                          int arg3)
+{
+  const struct syscall *sc = lookup_syscall (call_nr);
+
+  trace_event (TRACE_SYSCALL, call_nr, arg0);
+  return ((syscall_function *) sc->func) (arg0, arg1, arg2, arg3);
+}
+
+/* Copies a byte from user address USRC to kernel address DST.
+   USRC must be below PHYS_BASE.
+   Returns true if successful, false if a segfault occurred. */
+static inline bool
+get_user (uint8_t *dst, const uint8_t *usrc)
+{
+  int eax;
+  asm ("movl $1f, %%eax; movb %2, %%al; movb %%al, %0; 1:"
+       : "=m" (*dst), "=&a" (eax) : "m" (*usrc));
+  return eax != 0;
+}
+
+/* Writes BYTE to user address UDST.
+   UDST must be below PHYS_BASE.
+   Returns true if successful, false if a segfault occurred. */
+static inline bool
+put_user (uint8_t *udst, uint8_t byte)
+{
+  int eax;
+  asm ("movl $1f, %%eax; movb %b2, %0; 1:"
+       : "=m" (*udst), "=&a" (eax) : "q" (byte));
+  return eax != 0;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.
+   Call thread_exit() if any of the user accesses are invalid. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+copy_in (void *dst_, const void *usrc_, size_t size)
 {
-  printf ("system call!\n");
+  uint8_t *dst = dst_;
+  const uint8_t *usrc = usrc_;
+
+  for (; size > 0; size--, dst++, usrc++)
+    if (usrc >= (uint8_t *) PHYS_BASE || !get_user (dst, usrc))
+      thread_exit ();
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.
+   Call thread_exit() if any of the user accesses are invalid. */
+static void
+copy_out (void *udst_, const void *src_, size_t size)
+{
+  uint8_t *udst = udst_;
+  const uint8_t *src = src_;
+
+  for (; size > 0; size--, udst++, src++)
+    if (udst >= (uint8_t *) PHYS_BASE || !put_user (udst, *src))
+      thread_exit ();
+}
+
+/* Creates a copy of user string US in kernel memory
+   and returns it as a page that must be freed with
+   palloc_free_page().
+   Truncates the string at PGSIZE bytes in size.
+   Call thread_exit() if any of the user accesses are invalid. */
+static char *
+copy_in_string (const char *us)
+{
+  char *ks;
+  size_t length;
+
+  ks = palloc_get_page (0);
+  if (ks == NULL)
+    thread_exit ();
+
+  for (length = 0; length < PGSIZE; length++)
+    {
+      if (us >= (char *) PHYS_BASE || !get_user ((uint8_t *) ks + length,
+                                                 (const uint8_t *) us++))
+        {
+          palloc_free_page (ks);
+          thread_exit ();
+        }
+
+      if (ks[length] == '\0')
+        return ks;
+    }
+  ks[PGSIZE - 1] = '\0';
+  return ks;
+}
+
+/* Unpins the user pages that contain the bytes from UADDR up to
+   but not including UEND, which were pinned by pin_user(). */
+static void
+unpin_user (const void *uaddr, const void *uend)
+{
+#ifdef VM
+  const uint8_t *upage;
+
+  for (upage = pg_round_down (uaddr); upage < (const uint8_t *) uend;
+       upage += PGSIZE)
+    page_unlock (upage);
+#else
+  (void) uaddr;
+  (void) uend;
+#endif
+}
+
+/* Pins the user pages that hold the SIZE bytes at UADDR, which
+   must span at most PIN_PAGES pages, so that the kernel can
+   transfer data directly between them and a file or device
+   without faulting, even while holding locks.  If WILL_WRITE is
+   true, the pages must be writable.  Must be balanced by a call
+   to unpin_user().
+   Call thread_exit() if any of the pages is invalid. */
+static void
+pin_user (void *uaddr, size_t size, bool will_write)
+{
+  uint8_t *uend = (uint8_t *) uaddr + size;
+  uint8_t *upage;
+
+  if (size == 0)
+    return;
+  if (uend < (uint8_t *) uaddr || uend > (uint8_t *) PHYS_BASE)
+    thread_exit ();
+
+  for (upage = pg_round_down (uaddr); upage < uend; upage += PGSIZE)
+    {
+#ifdef VM
+      /* Make the page resident and keep the pager away from it. */
+      bool ok = page_lock (upage, will_write);
+#else
+      /* Without VM, pages never move, so it is enough to touch
+         each page the way the transfer will. */
+      uint8_t byte;
+      bool ok = (get_user (&byte, upage)
+                 && (!will_write || put_user (upage, byte)));
+#endif
+      if (!ok)
+        {
+          unpin_user (uaddr, upage);
+          thread_exit ();
+        }
+    }
+}
+
+/* Returns the number of bytes, at most SIZE, starting at user
+   address UADDR, that fit in a window of PIN_PAGES pages. */
+static size_t
+pin_window (const void *uaddr, size_t size)
+{
+  size_t max = PIN_PAGES * PGSIZE - pg_ofs (uaddr);
+  return size < max ? size : max;
+}
+
+/* Halt system call. */
+static int
+sys_halt (void)
+{
+  shutdown_power_off ();
+}
+
+/* Exit system call. */
+static int
+sys_exit (int exit_code)
+{
+  thread_current ()->wait_status->exit_code = exit_code;
   thread_exit ();
+  NOT_REACHED ();
+}
+
+/* Exec system call. */
+static int
+sys_exec (const char *ufile)
+{
+  tid_t tid;
+  char *kfile = copy_in_string (ufile);
+
+  tid = process_execute (kfile);
+
+  palloc_free_page (kfile);
+
+  return tid;
+}
+
+/* Wait system call. */
+static int
+sys_wait (tid_t child)
+{
+  return process_wait (child);
+}
+
+/* Create system call. */
+static int
+sys_create (const char *ufile, unsigned initial_size)
+{
+  char *kfile = copy_in_string (ufile);
+  bool ok;
+
+  lock_acquire (&filesys_lock);
+  ok = filesys_create (kfile, initial_size);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (kfile);
+
+  return ok;
+}
+
+/* Remove system call. */
+static int
+sys_remove (const char *ufile)
+{
+  char *kfile = copy_in_string (ufile);
+  bool ok;
+
+  lock_acquire (&filesys_lock);
+  ok = filesys_remove (kfile);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (kfile);
+
+  return ok;
+}
+
+/* A file descriptor, for binding a file handle to a file. */
+struct file_descriptor
+  {
+    struct list_elem elem;      /* List element. */
+    struct file *file;          /* File. */
+    int handle;                 /* File handle. */
+  };
+
+/* Open system call. */
+static int
+sys_open (const char *ufile)
+{
+  char *kfile = copy_in_string (ufile);
+  struct file_descriptor *fd;
+  int handle = -1;
+
+  fd = malloc (sizeof *fd);
+  if (fd != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      fd->file = filesys_open (kfile);
+      if (fd->file != NULL)
+        {
+          struct thread *cur = thread_current ();
+          handle = fd->handle = cur->next_handle++;
+          list_push_front (&cur->fds, &fd->elem);
+        }
+      else
+        free (fd);
+      lock_release (&filesys_lock);
+    }
+
+  palloc_free_page (kfile);
+  return handle;
+}
+
+/* Returns the file descriptor associated with the given handle.
+   Terminates the process if HANDLE is not associated with an
+   open file. */
+static struct file_descriptor *
+lookup_fd (int handle)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->fds); e != list_end (&cur->fds);
+       e = list_next (e))
+    {
+      struct file_descriptor *fd;
+      fd = list_entry (e, struct file_descriptor, elem);
+      if (fd->handle == handle)
+        return fd;
+    }
+
+  thread_exit ();
+}
+
+/* Filesize system call. */
+static int
+sys_filesize (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  int size;
+
+  lock_acquire (&filesys_lock);
+  size = file_length (fd->file);
+  lock_release (&filesys_lock);
+
+  return size;
+}
+
+/* Transfers SIZE bytes between the user buffer at UBUF and the
+   file or console behind HANDLE: reads into UBUF if WRITE is
+   false, writes from it if WRITE is true.  If POS is nonnull,
+   the transfer starts at file offset *POS, which is advanced,
+   and the file position is left alone; otherwise it starts at
+   and advances the file position.
+   Returns the number of bytes transferred, or -1 if the request
+   is invalid.
+
+   The user buffer is pinned a window at a time and the file
+   system transfers straight to or from it: whole sectors move
+   between the disk and the user's frames directly, and only
+   partial sectors pass through a kernel buffer. */
+static int
+transfer (int handle, uint8_t *ubuf, size_t size, off_t *pos, bool write)
+{
+  struct file_descriptor *fd = NULL;
+  int bytes_done = 0;
+
+  /* Handle keyboard reads.  Returns as soon as some input is
+     available, which may be less than SIZE bytes. */
+  if (handle == STDIN_FILENO && !write)
+    {
+      size_t chunk = pin_window (ubuf, size);
+      if (pos != NULL)
+        return -1;
+      if (chunk == 0)
+        return 0;
+      pin_user (ubuf, chunk, true);
+      bytes_done = input_read (ubuf, chunk);
+      unpin_user (ubuf, ubuf + chunk);
+      return bytes_done;
+    }
+
+  /* Look up file descriptor. */
+  if (handle == STDOUT_FILENO && write)
+    {
+      if (pos != NULL)
+        return -1;
+    }
+  else
+    fd = lookup_fd (handle);
+
+  while (size > 0)
+    {
+      size_t chunk = pin_window (ubuf, size);
+      off_t retval;
+
+      pin_user (ubuf, chunk, !write);
+      if (fd == NULL)
+        {
+          putbuf ((const char *) ubuf, chunk);
+          retval = chunk;
+        }
+      else
+        {
+          lock_acquire (&filesys_lock);
+          if (pos != NULL)
+            retval = (write
+                      ? file_write_at (fd->file, ubuf, chunk, *pos)
+                      : file_read_at (fd->file, ubuf, chunk, *pos));
+          else
+            retval = (write
+                      ? file_write (fd->file, ubuf, chunk)
+                      : file_read (fd->file, ubuf, chunk));
+          lock_release (&filesys_lock);
+        }
+      unpin_user (ubuf, ubuf + chunk);
+
+      if (retval < 0)
+        {
+          if (bytes_done == 0)
+            bytes_done = -1;
+          break;
+        }
+      bytes_done += retval;
+      if (pos != NULL)
+        *pos += retval;
+      if (retval != (off_t) chunk)
+        break;
+
+      ubuf += chunk;
+      size -= chunk;
+    }
+
+  return bytes_done;
+}
+
+/* Read system call. */
+static int
+sys_read (int handle, void *udst, unsigned size)
+{
+  return transfer (handle, udst, size, NULL, false);
+}
+
+/* Write system call. */
+static int
+sys_write (int handle, void *usrc, unsigned size)
+{
+  return transfer (handle, usrc, size, NULL, true);
+}
+
+/* Copies SIZE bytes between kernel buffer BUF and the user
+   buffers described by IOV, starting OFS bytes into element
+   *IDX, and advances *IDX and *OFS past them.  Copies from the
+   user buffers into BUF if TO_USER is false, from BUF into them
+   if it is true.  The caller guarantees that the elements hold
+   at least SIZE more bytes.
+   Returns true if successful, false if a user access was
+   invalid. */
+static bool
+copy_iov (const struct iovec *iov, int *idx, size_t *ofs, uint8_t *buf,
+          size_t size, bool to_user)
+{
+  while (size > 0)
+    {
+      uint8_t *ubuf = (uint8_t *) iov[*idx].iov_base + *ofs;
+      size_t left = iov[*idx].iov_len - *ofs;
+      size_t chunk = size < left ? size : left;
+      size_t i;
+
+      for (i = 0; i < chunk; i++)
+        {
+          if (ubuf + i >= (uint8_t *) PHYS_BASE)
+            return false;
+          if (to_user ? !put_user (ubuf + i, buf[i])
+                      : !get_user (buf + i, ubuf + i))
+            return false;
+        }
+
+      buf += chunk;
+      size -= chunk;
+      *ofs += chunk;
+      if (*ofs == iov[*idx].iov_len)
+        {
+          ++*idx;
+          *ofs = 0;
+        }
+    }
+  return true;
+}
+
+/* Transfers data between the file or console behind HANDLE and
+   the IOVCNT buffers described by the array at UIOV, in order,
+   stopping early at the first short transfer.  Reads if WRITE is
+   false, writes if it is true.  Returns the number of bytes
+   transferred, or -1 on error.
+
+   For a file, the buffers are gathered into, or scattered from,
+   a kernel buffer of up to VECTOR_PAGES pages.  A vector that
+   fits in the buffer thus reaches the file system as a single
+   request under a single acquisition of the file system lock,
+   however many elements it has.  The user buffers are copied
+   without the lock held, because touching them may page in data
+   from a file, which needs the lock.  The console, and a vector
+   of one element, are handed to transfer() instead. */
+static int
+transfer_vector (int handle, const struct iovec *uiov, int iovcnt,
+                 bool write)
+{
+  struct iovec iov[IOV_MAX];
+  struct file_descriptor *fd;
+  size_t total = 0;
+  size_t buf_pages;
+  uint8_t *buf;
+  int bytes_done = 0;
+  int idx = 0;
+  size_t ofs = 0;
+  int i;
+
+  if (iovcnt < 0 || iovcnt > IOV_MAX)
+    return -1;
+  copy_in (iov, uiov, sizeof *iov * iovcnt);
+  for (i = 0; i < iovcnt; i++)
+    {
+      if (iov[i].iov_len > INT_MAX - total)
+        return -1;
+      total += iov[i].iov_len;
+    }
+
+  if (handle == STDIN_FILENO || handle == STDOUT_FILENO || iovcnt == 1)
+    {
+      for (i = 0; i < iovcnt; i++)
+        {
+          int retval = transfer (handle, iov[i].iov_base, iov[i].iov_len,
+                                 NULL, write);
+          if (retval < 0)
+            return bytes_done > 0 ? bytes_done : -1;
+          bytes_done += retval;
+          if ((size_t) retval != iov[i].iov_len)
+            break;
+        }
+      return bytes_done;
+    }
+
+  fd = lookup_fd (handle);
+  if (total == 0)
+    return 0;
+
+  /* Use a smaller buffer if memory is tight. */
+  buf_pages = DIV_ROUND_UP (total, PGSIZE);
+  if (buf_pages > VECTOR_PAGES)
+    buf_pages = VECTOR_PAGES;
+  buf = palloc_get_multiple (0, buf_pages);
+  if (buf == NULL)
+    {
+      buf_pages = 1;
+      buf = palloc_get_page (0);
+      if (buf == NULL)
+        return -1;
+    }
+
+  while (total > 0)
+    {
+      size_t chunk = total < buf_pages * PGSIZE ? total : buf_pages * PGSIZE;
+      off_t retval;
+
+      if (write && !copy_iov (iov, &idx, &ofs, buf, chunk, false))
+        goto fault;
+
+      lock_acquire (&filesys_lock);
+      retval = (write
+                ? file_write (fd->file, buf, chunk)
+                : file_read (fd->file, buf, chunk));
+      lock_release (&filesys_lock);
+
+      if (retval < 0)
+        {
+          if (bytes_done == 0)
+            bytes_done = -1;
+          break;
+        }
+      if (!write && !copy_iov (iov, &idx, &ofs, buf, retval, true))
+        goto fault;
+      bytes_done += retval;
+      if (retval != (off_t) chunk)
+        break;
+      total -= chunk;
+    }
+
+  palloc_free_multiple (buf, buf_pages);
+  return bytes_done;
+
+ fault:
+  palloc_free_multiple (buf, buf_pages);
+  thread_exit ();
+}
+
+/* Readv system call. */
+static int
+sys_readv (int handle, const struct iovec *uiov, int iovcnt)
+{
+  return transfer_vector (handle, uiov, iovcnt, false);
+}
+
+/* Writev system call. */
+static int
+sys_writev (int handle, const struct iovec *uiov, int iovcnt)
+{
+  return transfer_vector (handle, uiov, iovcnt, true);
+}
+
+/* Pread system call. */
+static int
+sys_pread (int handle, void *udst, unsigned size, unsigned position)
+{
+  off_t pos = position;
+  if (pos < 0)
+    return -1;
+  return transfer (handle, udst, size, &pos, false);
+}
+
+/* Pwrite system call. */
+static int
+sys_pwrite (int handle, void *usrc, unsigned size, unsigned position)
+{
+  off_t pos = position;
+  if (pos < 0)
+    return -1;
+  return transfer (handle, usrc, size, &pos, true);
+}
+
+/* Copy_range system call.
+   Copies up to SIZE bytes from the file behind IN_HANDLE to the
+   file behind OUT_HANDLE, starting at and advancing each file's
+   position, without passing the data through user space.  The
+   data moves through a kernel buffer of COPY_PAGES pages, so
+   each chunk is read and written as a run of whole sectors with
+   one request each.  Returns the number of bytes copied, which
+   is less than SIZE if the end of either file is reached. */
+static int
+sys_copy_range (int in_handle, int out_handle, unsigned size)
+{
+  struct file_descriptor *in = lookup_fd (in_handle);
+  struct file_descriptor *out = lookup_fd (out_handle);
+  size_t buf_pages = COPY_PAGES;
+  uint8_t *buf;
+  int bytes_copied = 0;
+
+  /* Use a smaller buffer if memory is tight. */
+  buf = palloc_get_multiple (0, buf_pages);
+  if (buf == NULL)
+    {
+      buf_pages = 1;
+      buf = palloc_get_page (0);
+      if (buf == NULL)
+        return -1;
+    }
+
+  while (size > 0)
+    {
+      size_t chunk = size < buf_pages * PGSIZE ? size : buf_pages * PGSIZE;
+      off_t bytes_read, bytes_written = 0;
+
+      lock_acquire (&filesys_lock);
+      bytes_read = file_read (in->file, buf, chunk);
+      if (bytes_read > 0)
+        {
+          bytes_written = file_write (out->file, buf, bytes_read);
+
+          /* Don't consume input that could not be written. */
+          if (bytes_written < bytes_read)
+            file_seek (in->file, file_tell (in->file)
+                       - (bytes_read - bytes_written));
+        }
+      lock_release (&filesys_lock);
+
+      bytes_copied += bytes_written;
+      if (bytes_written != (off_t) chunk)
+        break;
+      size -= chunk;
+    }
+
+  palloc_free_multiple (buf, buf_pages);
+  return bytes_copied;
+}
+
+/* Ring_submit system call.
+   Carries out the calls queued in URING from its tail up to its
+   head, storing each result and advancing the tail as each call
+   completes.  Returns the number of calls carried out, or -1 if
+   the ring's indexes are inconsistent. */
+static int
+sys_ring_submit (struct sys_ring *uring)
+{
+  unsigned head, tail, next;
+  int cnt = 0;
+
+  copy_in (&head, &uring->head, sizeof head);
+  copy_in (&tail, &uring->tail, sizeof tail);
+  if (head - tail > SYS_RING_SIZE)
+    return -1;
+
+  for (; tail != head; tail++, cnt++)
+    {
+      struct sys_op *uop = &uring->ops[tail & (SYS_RING_SIZE - 1)];
+      const struct syscall *sc;
+      struct sys_op op;
+
+      copy_in (&op, uop, sizeof op);
+      if (op.call_nr >= 0
+          && (size_t) op.call_nr < sizeof syscall_table / sizeof *syscall_table
+          && syscall_table[op.call_nr].func != NULL
+          && syscall_table[op.call_nr].batchable)
+        {
+          sc = syscall_table + op.call_nr;
+          trace_event (TRACE_SYSCALL, op.call_nr, op.args[0]);
+          op.result = ((syscall_function *) sc->func) (op.args[0],
+                                                       op.args[1],
+                                                       op.args[2],
+                                                       op.args[3]);
+        }
+      else
+        op.result = -1;
+
+      copy_out (&uop->result, &op.result, sizeof op.result);
+      next = tail + 1;
+      copy_out (&uring->tail, &next, sizeof next);
+    }
+
+  return cnt;
+}
+
+/* Sysenter system call.
+   Returns true if the process may enter system calls with
+   SYSENTER.  It does nothing else, so it also serves to measure
+   the cost of entering and leaving the kernel. */
+static int
+sys_sysenter (void)
+{
+  return syscall_sysenter;
+}
+
+/* Seek system call. */
+static int
+sys_seek (int handle, unsigned position)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+
+  lock_acquire (&filesys_lock);
+  if ((off_t) position >= 0)
+    file_seek (fd->file, position);
+  lock_release (&filesys_lock);
+
+  return 0;
+}
+
+/* Tell system call. */
+static int
+sys_tell (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  unsigned position;
+
+  lock_acquire (&filesys_lock);
+  position = file_tell (fd->file);
+  lock_release (&filesys_lock);
+
+  return position;
+}
+
+/* Close system call. */
+static int
+sys_close (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  lock_acquire (&filesys_lock);
+  file_close (fd->file);
+  lock_release (&filesys_lock);
+  list_remove (&fd->elem);
+  free (fd);
+  return 0;
+}
+
+/* Sbrk system call. */
+static int
+sys_sbrk (intptr_t increment)
+{
+  return (int) process_sbrk (increment);
+}
+
+/* On thread exit, close all open files. */
+void
+syscall_exit (void)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e, *next;
+
+  for (e = list_begin (&cur->fds); e != list_end (&cur->fds); e = next)
+    {
+      struct file_descriptor *fd;
+      fd = list_entry (e, struct file_descriptor, elem);
+      next = list_next (e);
+      lock_acquire (&filesys_lock);
+      file_close (fd->file);
+      lock_release (&filesys_lock);
+      free (fd);
+    }
 }
@@ -1,6 +1,15 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+
+/* Allow SYSENTER system call entry? */
+extern bool syscall_sysenter;
+
 void syscall_init (void);
+void syscall_exit (void);
+
+/* SYSENTER entry point, in syscall-entry.S. */
+void syscall_sysenter_entry (void);
 
 #endif /* userprog/syscall.h */
@@ -1,7 +1,9 @@
 #include "userprog/tss.h"
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -75,6 +77,11 @@ struct tss
 /* Kernel TSS. */
 static struct tss *tss;
 
+/* True if SYSENTER is in use.  SYSENTER does not consult the
+   TSS, so its stack pointer MSR must then be kept equal to
+   esp0. */
+static bool sysenter_on;
+
 /* Initializes the kernel TSS. */
 void
 tss_init (void) 
@@ -103,4 +110,16 @@ tss_update (void)
 {
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
+  if (sysenter_on)
+    wrmsr (MSR_SYSENTER_ESP, (uintptr_t) tss->esp0);
+}
+
+/* Keeps the SYSENTER stack pointer equal to the TSS's esp0 from
+   now on.  The caller must have checked that the CPU supports
+   SYSENTER. */
+void
+tss_enable_sysenter (void) 
+{
+  sysenter_on = true;
+  tss_update ();
 }
@@ -0,0 +1,418 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include "vm/page.h"
+#include "vm/swap.h"
+#include "threads/init.h"
+#include "threads/loader.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Frame table.
+
+   Every page in the user pool is claimed at startup and
+   described by one element of FRAMES[].  Frames that hold no
+   page sit on FREE_FRAMES.  When the number of free frames
+   falls below the low watermark, the "pager" thread is woken up
+   to evict cold frames, in batches, until the high watermark is
+   reached again, so that a faulting process usually finds a free
+   frame immediately.  If the free list is empty anyway, the
+   faulting process evicts a frame itself ("direct reclaim"),
+   and if that fails too, it waits for the pager to free one. */
+
+static struct frame *frames;
+static size_t frame_cnt;
+
+/* Protects FREE_FRAMES, FREE_CNT, HAND, PAGER_BUSY, and
+   PAGER_RECLAIM_CNT.
+   Never held while acquiring a frame's lock or doing I/O. */
+static struct lock scan_lock;
+static struct list free_frames;
+static size_t free_cnt;
+static size_t hand;
+
+/* Signaled when frames are freed or the pager goes back to
+   sleep, for processes waiting in frame_alloc_and_lock(). */
+static struct condition frames_freed;
+
+/* Free frame watermarks, in frames. */
+static size_t low_water, high_water;
+
+/* Pager thread. */
+static struct semaphore pager_sema;     /* Upped to wake the pager. */
+static bool pager_busy;                 /* Pager awake? */
+
+/* Number of frames the pager evicts or cleans before yielding.
+   Dirty pages evicted in one batch get contiguous swap slots. */
+#define PAGER_BATCH SWAP_CLUSTER_MAX
+
+/* Statistics. */
+static long long direct_reclaim_cnt;    /* # of frames evicted by faults. */
+static long long pager_reclaim_cnt;     /* # of frames evicted by pager. */
+static long long pager_clean_cnt;       /* # of frames cleaned by pager. */
+static long long pager_wakeup_cnt;      /* # of times pager was woken. */
+
+static thread_func pager NO_RETURN;
+static struct frame *evict_frame (void);
+
+/* Initialize the frame manager.  The pager keeps at least
+   LOW_WATER_ frames free, reclaiming up to HIGH_WATER_ at a time.
+   SIZE_MAX selects the default for either watermark, and a low
+   watermark of 0 disables the pager. */
+void
+frame_init (size_t low_water_, size_t high_water_)
+{
+  void *base;
+
+  lock_init (&scan_lock);
+  lock_set_name (&scan_lock, "frame scan");
+  list_init (&free_frames);
+  cond_init (&frames_freed);
+
+  frames = malloc (sizeof *frames * init_ram_pages);
+  if (frames == NULL)
+    PANIC ("out of memory allocating page frames");
+
+  while ((base = palloc_get_page (PAL_USER)) != NULL)
+    {
+      struct frame *f = &frames[frame_cnt++];
+      lock_init (&f->lock);
+      f->base = base;
+      f->page = NULL;
+      list_push_back (&free_frames, &f->free_elem);
+    }
+  free_cnt = frame_cnt;
+
+  low_water = low_water_ != SIZE_MAX ? low_water_ : frame_cnt / 32 + 1;
+  high_water = high_water_ != SIZE_MAX ? high_water_ : low_water * 2;
+  if (low_water > frame_cnt)
+    low_water = frame_cnt;
+  if (high_water < low_water)
+    high_water = low_water;
+  if (high_water > frame_cnt)
+    high_water = frame_cnt;
+
+  sema_init (&pager_sema, 0);
+  if (low_water > 0
+      && thread_create ("pager", PRI_DEFAULT, pager, NULL) == TID_ERROR)
+    PANIC ("couldn't start pager thread");
+}
+
+/* Tries to allocate and lock a frame for PAGE.
+   Takes a free frame if there is one, otherwise evicts a frame
+   directly.  Returns the frame if successful, a null pointer
+   on failure. */
+static struct frame *
+try_frame_alloc_and_lock (struct page *page)
+{
+  struct frame *f = NULL;
+
+  lock_acquire (&scan_lock);
+  if (!list_empty (&free_frames))
+    {
+      f = list_entry (list_pop_front (&free_frames), struct frame, free_elem);
+      free_cnt--;
+    }
+  if (free_cnt < low_water && !pager_busy)
+    {
+      pager_busy = true;
+      pager_wakeup_cnt++;
+      sema_up (&pager_sema);
+    }
+  lock_release (&scan_lock);
+
+  if (f != NULL)
+    lock_acquire (&f->lock);
+  else
+    {
+      f = evict_frame ();
+      if (f == NULL)
+        return NULL;
+      lock_acquire (&scan_lock);
+      direct_reclaim_cnt++;
+      lock_release (&scan_lock);
+    }
+
+  ASSERT (f->page == NULL);
+  f->page = page;
+  return f;
+}
+
+/* Tries really hard to allocate and lock a frame for PAGE.
+   If neither the free list nor direct reclaim yields a frame,
+   waits for the pager, which try_frame_alloc_and_lock() has
+   woken, to free one, and tries again.  Gives up only once the
+   pager has gone back to sleep without freeing anything.
+   Returns the frame if successful, a null pointer on failure. */
+struct frame *
+frame_alloc_and_lock (struct page *page)
+{
+  for (;;)
+    {
+      struct frame *f = try_frame_alloc_and_lock (page);
+      long long progress;
+      bool give_up;
+
+      if (f != NULL)
+        {
+          ASSERT (lock_held_by_current_thread (&f->lock));
+          return f;
+        }
+
+      lock_acquire (&scan_lock);
+      progress = pager_reclaim_cnt;
+      while (pager_busy && list_empty (&free_frames))
+        cond_wait (&frames_freed, &scan_lock);
+      give_up = (list_empty (&free_frames) && !pager_busy
+                 && pager_reclaim_cnt == progress);
+      lock_release (&scan_lock);
+
+      if (give_up)
+        return NULL;
+    }
+}
+
+/* Allocates and locks a free frame for PAGE without evicting
+   anything, and only if more frames than the low watermark are
+   free, so that speculative reads such as swap read-around never
+   cause reclaim.  Returns the frame if successful, a null
+   pointer otherwise. */
+struct frame *
+frame_alloc_free_and_lock (struct page *page)
+{
+  struct frame *f = NULL;
+
+  lock_acquire (&scan_lock);
+  if (free_cnt > low_water && !list_empty (&free_frames))
+    {
+      f = list_entry (list_pop_front (&free_frames), struct frame, free_elem);
+      free_cnt--;
+    }
+  lock_release (&scan_lock);
+
+  if (f != NULL)
+    {
+      lock_acquire (&f->lock);
+      ASSERT (f->page == NULL);
+      f->page = page;
+    }
+  return f;
+}
+
+/* Locks P's frame into memory, if it has one.
+   Upon return, p->frame will not change until P is unlocked. */
+void
+frame_lock (struct page *p)
+{
+  /* A frame can be asynchronously removed, but never inserted. */
+  struct frame *f = p->frame;
+  if (f != NULL)
+    {
+      lock_acquire (&f->lock);
+      if (f != p->frame)
+        {
+          lock_release (&f->lock);
+          ASSERT (p->frame == NULL);
+        }
+    }
+}
+
+/* Releases frame F for use by another page.
+   F must be locked for use by the current process.
+   Any data in F is lost. */
+void
+frame_free (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+
+  f->page = NULL;
+  lock_release (&f->lock);
+
+  lock_acquire (&scan_lock);
+  list_push_back (&free_frames, &f->free_elem);
+  free_cnt++;
+  cond_signal (&frames_freed, &scan_lock);
+  lock_release (&scan_lock);
+}
+
+/* Unlocks frame F, allowing it to be evicted.
+   F must be locked for use by the current process. */
+void
+frame_unlock (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  lock_release (&f->lock);
+}
+
+/* Prints frame and reclaim statistics. */
+void
+frame_print_stats (void)
+{
+  printf ("Frames: %zu frames, %zu free, watermarks %zu/%zu\n",
+          frame_cnt, free_cnt, low_water, high_water);
+  printf ("Reclaim: %lld direct, %lld background, %lld pre-cleaned, "
+          "%lld pager wakeups\n",
+          direct_reclaim_cnt, pager_reclaim_cnt, pager_clean_cnt,
+          pager_wakeup_cnt);
+}
+
+/* Advances the clock hand and returns the frame it passed. */
+static struct frame *
+advance_hand (void)
+{
+  struct frame *f;
+
+  lock_acquire (&scan_lock);
+  f = &frames[hand];
+  if (++hand >= frame_cnt)
+    hand = 0;
+  lock_release (&scan_lock);
+
+  return f;
+}
+
+/* Chooses a frame to evict with the clock algorithm and evicts
+   its page.  Returns the frame, locked and empty, or a null
+   pointer if no frame could be evicted. */
+static struct frame *
+evict_frame (void)
+{
+  size_t i;
+
+  for (i = 0; i < frame_cnt * 2; i++)
+    {
+      struct frame *f = advance_hand ();
+
+      if (!lock_try_acquire (&f->lock))
+        continue;
+
+      if (f->page == NULL || page_accessed_recently (f->page)
+          || !page_out (f->page))
+        {
+          lock_release (&f->lock);
+          continue;
+        }
+
+      f->page = NULL;
+      return f;
+    }
+
+  return NULL;
+}
+
+/* Chooses up to CNT frames to evict with the clock algorithm
+   and evicts their pages, giving the dirty ones a contiguous run
+   of swap slots.  Frees the evicted frames and returns how many
+   there were. */
+static size_t
+evict_batch (size_t cnt)
+{
+  struct frame *victims[PAGER_BATCH];
+  struct page *pages[PAGER_BATCH];
+  size_t victim_cnt = 0;
+  size_t evicted = 0;
+  size_t i;
+
+  ASSERT (cnt <= PAGER_BATCH);
+
+  for (i = 0; i < frame_cnt * 2 && victim_cnt < cnt; i++)
+    {
+      struct frame *f = advance_hand ();
+
+      if (!lock_try_acquire (&f->lock))
+        continue;
+
+      if (f->page == NULL || page_accessed_recently (f->page))
+        {
+          lock_release (&f->lock);
+          continue;
+        }
+
+      victims[victim_cnt] = f;
+      pages[victim_cnt++] = f->page;
+    }
+
+  swap_reserve_cluster (pages, victim_cnt);
+  for (i = 0; i < victim_cnt; i++)
+    {
+      struct frame *f = victims[i];
+
+      if (page_out (f->page))
+        {
+          frame_free (f);
+          evicted++;
+        }
+      else
+        lock_release (&f->lock);
+    }
+
+  return evicted;
+}
+
+/* Writes back the dirty pages in the next PAGER_BATCH frames
+   that the clock hand will reach, without evicting them, so that
+   evicting them later is cheap. */
+static void
+preclean_frames (void)
+{
+  size_t start, i;
+
+  lock_acquire (&scan_lock);
+  start = hand;
+  lock_release (&scan_lock);
+
+  for (i = 0; i < PAGER_BATCH && i < frame_cnt; i++)
+    {
+      struct frame *f = &frames[(start + i) % frame_cnt];
+
+      if (!lock_try_acquire (&f->lock))
+        continue;
+      if (f->page != NULL && page_is_dirty (f->page) && page_clean (f->page))
+        pager_clean_cnt++;
+      lock_release (&f->lock);
+    }
+}
+
+/* Pager thread.  Sleeps until the number of free frames drops
+   below the low watermark, then evicts frames, PAGER_BATCH at a
+   time, until it reaches the high watermark. */
+static void
+pager (void *aux UNUSED)
+{
+  for (;;)
+    {
+      sema_down (&pager_sema);
+
+      for (;;)
+        {
+          size_t free, want, evicted;
+
+          lock_acquire (&scan_lock);
+          free = free_cnt;
+          lock_release (&scan_lock);
+          if (free >= high_water)
+            break;
+
+          want = high_water - free;
+          evicted = evict_batch (want < PAGER_BATCH ? want : PAGER_BATCH);
+          if (evicted == 0)
+            break;
+          lock_acquire (&scan_lock);
+          pager_reclaim_cnt += evicted;
+          cond_broadcast (&frames_freed, &scan_lock);
+          lock_release (&scan_lock);
+
+          /* Let faulting processes at the new frames. */
+          thread_yield ();
+        }
+      preclean_frames ();
+
+      lock_acquire (&scan_lock);
+      pager_busy = false;
+      cond_broadcast (&frames_freed, &scan_lock);
+      lock_release (&scan_lock);
+    }
+}
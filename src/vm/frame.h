@@ -0,0 +1,29 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* A physical frame. */
+struct frame
+  {
+    struct lock lock;           /* Prevent simultaneous access. */
+    void *base;                 /* Kernel virtual base address. */
+    struct page *page;          /* Mapped process page, if any. */
+    struct list_elem free_elem; /* Element in free frame list. */
+  };
+
+void frame_init (size_t low_water, size_t high_water);
+
+struct frame *frame_alloc_and_lock (struct page *);
+struct frame *frame_alloc_free_and_lock (struct page *);
+void frame_lock (struct page *);
+
+void frame_free (struct frame *);
+void frame_unlock (struct frame *);
+
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
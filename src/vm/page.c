@@ -0,0 +1,460 @@
+#include "vm/page.h"
+#include <stdio.h>
+#include <string.h>
+#include "vm/frame.h"
+#include "vm/swap.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/interrupt.h"
+#include "threads/kmem.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+
+/* Supplemental page table.
+
+   Each process has a hash table of the user virtual pages it
+   may access.  A page's contents live in a frame while it is
+   resident, otherwise in its swap slot, its backing file, or
+   (for pages never written) nowhere at all, in which case the
+   page reads back as zeros. */
+
+/* Number of swapped-out neighbors read in along with a page. */
+#define READ_AROUND_PAGES 8
+
+/* If true, print each process's paging statistics when it exits.
+   Controlled by kernel command-line option "-vmstat". */
+bool page_stats_on_exit;
+
+/* Cache of `struct page's. */
+static struct kmem_cache page_cache;
+
+static unsigned page_hash (const struct hash_elem *, void *aux);
+static bool page_less (const struct hash_elem *, const struct hash_elem *,
+                       void *aux);
+
+/* Initializes the supplemental page table module. */
+void
+page_init (void) 
+{
+  kmem_cache_init (&page_cache, "page", sizeof (struct page), NULL);
+}
+
+/* Creates and returns an empty page table for a new process,
+   or a null pointer if memory is exhausted. */
+struct hash *
+page_table_create (void)
+{
+  struct hash *pages = malloc (sizeof *pages);
+  if (pages != NULL && !hash_init (pages, page_hash, page_less, NULL))
+    {
+      free (pages);
+      pages = NULL;
+    }
+  return pages;
+}
+
+/* Adds DELTA to the resident set size of page P's owner.
+   Called by the owner and by the pager, so it must be atomic. */
+static void
+adjust_rss (struct page *p, int delta)
+{
+  struct thread *t = p->thread;
+  enum intr_level old_level = intr_disable ();
+  t->rss += delta;
+  if (t->rss > t->peak_rss)
+    t->peak_rss = t->rss;
+  intr_set_level (old_level);
+}
+
+/* Accounts for the eviction of page P: drops it from its
+   owner's resident set and bumps the owner's eviction count.
+   Called by the pager, so it must be atomic like adjust_rss(). */
+static void
+count_eviction (struct page *p)
+{
+  struct thread *t = p->thread;
+  enum intr_level old_level = intr_disable ();
+  t->evictions++;
+  t->rss--;
+  intr_set_level (old_level);
+}
+
+/* Destroys a page, which must be in the current process's
+   page table.  Used as a callback for hash_destroy(). */
+static void
+destroy_page (struct hash_elem *p_, void *aux UNUSED)
+{
+  struct page *p = hash_entry (p_, struct page, hash_elem);
+  frame_lock (p);
+  if (p->frame != NULL)
+    {
+      pagedir_clear_page (p->thread->pagedir, p->addr);
+      frame_free (p->frame);
+      adjust_rss (p, -1);
+    }
+  swap_free (p);
+  kmem_cache_free (&page_cache, p);
+}
+
+/* Prints the running process's paging statistics. */
+void
+page_print_stats (void)
+{
+  struct thread *t = thread_current ();
+  printf ("%s: %u minor faults, %u major faults (%u file, %u swap), "
+          "%u evictions, %u resident pages (peak %u)\n",
+          t->name, t->minor_faults, t->file_faults + t->swap_faults,
+          t->file_faults, t->swap_faults, t->evictions, t->rss,
+          t->peak_rss);
+}
+
+/* Destroys the current process's page table. */
+void
+page_exit (void)
+{
+  struct hash *h = thread_current ()->pages;
+  if (h != NULL)
+    {
+      hash_destroy (h, destroy_page);
+      free (h);
+      thread_current ()->pages = NULL;
+    }
+}
+
+/* Returns the page containing the given virtual ADDRESS,
+   or a null pointer if no such page exists. */
+static struct page *
+page_for_addr (const void *address)
+{
+  if (address < PHYS_BASE)
+    {
+      struct page p;
+      struct hash_elem *e;
+
+      p.addr = (void *) pg_round_down (address);
+      e = hash_find (thread_current ()->pages, &p.hash_elem);
+      if (e != NULL)
+        return hash_entry (e, struct page, hash_elem);
+    }
+
+  return NULL;
+}
+
+/* Locks a frame for page P and pages it in.
+   Returns true if successful, false on failure. */
+static bool
+do_page_in (struct page *p)
+{
+  /* Get a frame for the page. */
+  p->frame = frame_alloc_and_lock (p);
+  if (p->frame == NULL)
+    return false;
+
+  /* Copy data into the frame. */
+  if (p->sector != (block_sector_t) -1)
+    {
+      /* Get data from swap. */
+      if (!swap_in (p))
+        {
+          frame_free (p->frame);
+          p->frame = NULL;
+          return false;
+        }
+      p->thread->swap_faults++;
+    }
+  else if (p->file != NULL)
+    {
+      /* Get data from file. */
+      off_t read_bytes, zero_bytes;
+
+      lock_acquire (&filesys_lock);
+      read_bytes = file_read_at (p->file, p->frame->base,
+                                 p->file_bytes, p->file_offset);
+      lock_release (&filesys_lock);
+      zero_bytes = PGSIZE - read_bytes;
+      memset ((uint8_t *) p->frame->base + read_bytes, 0, zero_bytes);
+      if (read_bytes != p->file_bytes)
+        printf ("bytes read (%"PROTd") != bytes requested (%"PROTd")\n",
+                read_bytes, p->file_bytes);
+      p->thread->file_faults++;
+    }
+  else
+    {
+      /* Provide all-zero page. */
+      memset (p->frame->base, 0, PGSIZE);
+      p->thread->minor_faults++;
+    }
+
+  adjust_rss (p, 1);
+  return true;
+}
+
+/* Reads in and maps the pages of the running process that were
+   swapped out next to page P, as long as free frames are
+   plentiful, so that a process touching pages that were evicted
+   together does not fault on them one at a time. */
+static void
+read_around (struct page *p)
+{
+  struct page *neighbors[READ_AROUND_PAGES];
+  size_t cnt = swap_neighbors (p, neighbors, READ_AROUND_PAGES);
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      struct page *q = neighbors[i];
+
+      frame_lock (q);
+      if (q->frame != NULL)
+        {
+          /* Already resident. */
+          frame_unlock (q->frame);
+          continue;
+        }
+
+      q->frame = frame_alloc_free_and_lock (q);
+      if (q->frame == NULL)
+        break;
+      swap_read_around (q);
+      adjust_rss (q, 1);
+      pagedir_set_page (q->thread->pagedir, q->addr, q->frame->base,
+                        !q->read_only);
+      frame_unlock (q->frame);
+    }
+}
+
+/* Faults in the page containing FAULT_ADDR.
+   Returns true if successful, false on failure. */
+bool
+page_in (void *fault_addr)
+{
+  struct page *p;
+  bool swapped_in = false;
+  bool success;
+
+  /* Can't handle page faults without a hash table. */
+  if (thread_current ()->pages == NULL)
+    return false;
+
+  p = page_for_addr (fault_addr);
+  if (p == NULL)
+    return false;
+
+  frame_lock (p);
+  if (p->frame == NULL)
+    {
+      swapped_in = p->sector != (block_sector_t) -1;
+      if (!do_page_in (p))
+        return false;
+    }
+  else
+    {
+      /* Resident, but not mapped, e.g. after a failed eviction. */
+      p->thread->minor_faults++;
+    }
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  /* Install frame into page table. */
+  success = pagedir_set_page (thread_current ()->pagedir, p->addr,
+                              p->frame->base, !p->read_only);
+
+  /* Release frame. */
+  frame_unlock (p->frame);
+
+  if (success && swapped_in)
+    read_around (p);
+
+  return success;
+}
+
+/* Evicts page P.
+   P must have a locked frame.
+   Return true if successful, false on failure. */
+bool
+page_out (struct page *p)
+{
+  bool dirty;
+  bool ok;
+
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  /* Mark page not present in page table, forcing accesses by the
+     process to fault.  This must happen before checking the
+     dirty bit, to prevent a race with the process dirtying the
+     page. */
+  pagedir_clear_page (p->thread->pagedir, p->addr);
+
+  /* Has the frame been modified since it was last read in or
+     written out?  If not, its swap slot, its file, or the zero
+     page still holds an identical copy. */
+  dirty = pagedir_is_dirty (p->thread->pagedir, p->addr);
+  ok = !dirty || swap_out (p);
+
+  if (ok)
+    {
+      p->frame = NULL;
+      count_eviction (p);
+    }
+  else
+    {
+      /* Put the page back, still dirty. */
+      pagedir_set_page (p->thread->pagedir, p->addr, p->frame->base,
+                        !p->read_only);
+      pagedir_set_dirty (p->thread->pagedir, p->addr, true);
+    }
+  return ok;
+}
+
+/* Writes page P to swap if it is dirty, leaving it resident but
+   clean, so that a later page_out() need not write it.
+   P must have a locked frame.
+   Returns true if P was written, false otherwise. */
+bool
+page_clean (struct page *p)
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  if (!pagedir_is_dirty (p->thread->pagedir, p->addr))
+    return false;
+
+  /* Clear the dirty bit before writing, so that modifications
+     made while the write is in progress leave the page dirty. */
+  pagedir_set_dirty (p->thread->pagedir, p->addr, false);
+  if (!swap_out (p))
+    {
+      pagedir_set_dirty (p->thread->pagedir, p->addr, true);
+      return false;
+    }
+  return true;
+}
+
+/* Returns true if page P's data has been accessed recently,
+   false otherwise.
+   P must have a frame locked into memory. */
+bool
+page_accessed_recently (struct page *p)
+{
+  bool was_accessed;
+
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  was_accessed = pagedir_is_accessed (p->thread->pagedir, p->addr);
+  if (was_accessed)
+    pagedir_set_accessed (p->thread->pagedir, p->addr, false);
+  return was_accessed;
+}
+
+/* Returns true if page P has been modified since it was last
+   brought in or written to swap.
+   P must have a frame locked into memory. */
+bool
+page_is_dirty (struct page *p)
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  return pagedir_is_dirty (p->thread->pagedir, p->addr);
+}
+
+/* Adds a mapping for user virtual address VADDR to the page hash
+   table.  Fails if VADDR is already mapped or if memory
+   allocation fails. */
+struct page *
+page_allocate (void *vaddr, bool read_only)
+{
+  struct thread *t = thread_current ();
+  struct page *p = kmem_cache_alloc (&page_cache);
+  if (p != NULL)
+    {
+      p->addr = pg_round_down (vaddr);
+      p->read_only = read_only;
+      p->thread = t;
+      p->frame = NULL;
+      p->sector = (block_sector_t) -1;
+      p->file = NULL;
+      p->file_offset = 0;
+      p->file_bytes = 0;
+
+      if (hash_insert (t->pages, &p->hash_elem) != NULL)
+        {
+          /* Already mapped. */
+          kmem_cache_free (&page_cache, p);
+          p = NULL;
+        }
+    }
+  return p;
+}
+
+/* Evicts the page containing address VADDR
+   and removes it from the page table. */
+void
+page_deallocate (void *vaddr)
+{
+  struct page *p = page_for_addr (vaddr);
+  ASSERT (p != NULL);
+  hash_delete (thread_current ()->pages, &p->hash_elem);
+  destroy_page (&p->hash_elem, NULL);
+}
+
+/* Makes the page containing user virtual address ADDR resident
+   and locks it into its frame, so that the kernel may access it
+   directly, without faulting and without the pager evicting it.
+   If WILL_WRITE is true, the page must be writable.
+   Returns true if successful, false if ADDR is not a valid
+   address for the access. */
+bool
+page_lock (const void *addr, bool will_write)
+{
+  struct page *p = page_for_addr (addr);
+  if (p == NULL || (p->read_only && will_write))
+    return false;
+
+  frame_lock (p);
+  if (p->frame == NULL && !do_page_in (p))
+    return false;
+
+  /* Map the frame, unless it is already.  Accessing it unmapped
+     would fault, and page_in() would then try to lock the frame
+     again. */
+  if (pagedir_get_page (p->thread->pagedir, p->addr) == NULL
+      && !pagedir_set_page (p->thread->pagedir, p->addr, p->frame->base,
+                            !p->read_only))
+    {
+      frame_unlock (p->frame);
+      return false;
+    }
+  return true;
+}
+
+/* Unlocks a page locked with page_lock(). */
+void
+page_unlock (const void *addr)
+{
+  struct page *p = page_for_addr (addr);
+  ASSERT (p != NULL);
+  frame_unlock (p->frame);
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return ((uintptr_t) p->addr) >> PGBITS;
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->addr < b->addr;
+}
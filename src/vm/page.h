@@ -0,0 +1,54 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include "devices/block.h"
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+/* Virtual page. */
+struct page
+  {
+    /* Immutable members. */
+    void *addr;                 /* User virtual address. */
+    bool read_only;             /* Read-only page? */
+    struct thread *thread;      /* Owning thread. */
+
+    /* Accessed only in owning process context. */
+    struct hash_elem hash_elem; /* struct thread `pages' hash element. */
+
+    /* Set only in owning process context with frame->lock held.
+       Cleared only with scan_lock and frame->lock held. */
+    struct frame *frame;        /* Page frame. */
+
+    /* Swap information, protected by frame->lock. */
+    block_sector_t sector;      /* Starting sector of swap area, or -1. */
+
+    /* Backing file information, if any.  Used to fill the page
+       lazily the first time it is brought in. */
+    struct file *file;          /* File, or NULL for anonymous pages. */
+    off_t file_offset;          /* Offset in file. */
+    off_t file_bytes;           /* Bytes to read/write, 1...PGSIZE. */
+  };
+
+/* If true, print each process's paging statistics at exit.
+   Controlled by kernel command-line option "-vmstat". */
+extern bool page_stats_on_exit;
+
+void page_init (void);
+struct hash *page_table_create (void);
+void page_exit (void);
+void page_print_stats (void);
+
+struct page *page_allocate (void *, bool read_only);
+void page_deallocate (void *vaddr);
+
+bool page_in (void *fault_addr);
+bool page_lock (const void *, bool will_write);
+void page_unlock (const void *);
+bool page_out (struct page *);
+bool page_clean (struct page *);
+bool page_accessed_recently (struct page *);
+bool page_is_dirty (struct page *);
+
+#endif /* vm/page.h */
@@ -0,0 +1,251 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Swap partition.  Divided into page-size "slots", each of
+   which holds the contents of one evicted page.
+
+   Pages that the pager evicts together are given a contiguous
+   run of slots, in order of owning process and virtual address,
+   so that a process that faults one of them back in can cheaply
+   read its swapped-out neighbours along with it. */
+
+/* The swap device. */
+static struct block *swap_device;
+
+/* Used swap slots. */
+static struct bitmap *swap_bitmap;
+
+/* Next-fit search position in swap_bitmap. */
+static size_t slot_cursor;
+
+/* Page occupying each swap slot, or a null pointer. */
+static struct page **slot_pages;
+
+/* Protects swap_bitmap, slot_cursor, slot_pages, and each
+   page's `sector' while it is being assigned or released. */
+static struct lock swap_lock;
+
+/* Number of sectors per page. */
+#define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* Statistics. */
+static long long page_write_cnt;        /* # of pages written. */
+static long long page_read_cnt;         /* # of pages read on fault. */
+static long long cluster_cnt;           /* # of multi-slot clusters. */
+static long long read_around_cnt;       /* # of pages read around. */
+
+/* Sets up swap. */
+void
+swap_init (void)
+{
+  size_t slot_cnt = 0;
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL)
+    printf ("no swap device--swap disabled\n");
+  else
+    slot_cnt = block_size (swap_device) / PAGE_SECTORS;
+
+  swap_bitmap = bitmap_create (slot_cnt);
+  slot_pages = calloc (slot_cnt > 0 ? slot_cnt : 1, sizeof *slot_pages);
+  if (swap_bitmap == NULL || slot_pages == NULL)
+    PANIC ("couldn't create swap bitmap");
+  lock_init (&swap_lock);
+  lock_set_name (&swap_lock, "swap");
+}
+
+/* Gives page P the swap slot SLOT.
+   swap_lock must be held. */
+static void
+assign_slot (struct page *p, size_t slot)
+{
+  ASSERT (lock_held_by_current_thread (&swap_lock));
+  ASSERT (slot_pages[slot] == NULL);
+
+  slot_pages[slot] = p;
+  p->sector = slot * PAGE_SECTORS;
+}
+
+/* Returns true if page A should precede page B in a cluster. */
+static bool
+cluster_less (const struct page *a, const struct page *b)
+{
+  if (a->thread != b->thread)
+    return a->thread < b->thread;
+  return a->addr < b->addr;
+}
+
+/* Reserves a contiguous run of swap slots for those of the CNT
+   pages in PAGES[] that are dirty and do not have a slot yet,
+   in order of owning process and virtual address.  Each page
+   must have a locked frame.  If no run is long enough, does
+   nothing, and swap_out() falls back to scattered slots. */
+void
+swap_reserve_cluster (struct page *pages[], size_t cnt)
+{
+  struct page *need[SWAP_CLUSTER_MAX];
+  size_t need_cnt = 0;
+  size_t i, first;
+
+  ASSERT (cnt <= SWAP_CLUSTER_MAX);
+  for (i = 0; i < cnt; i++)
+    if (pages[i]->sector == (block_sector_t) -1 && page_is_dirty (pages[i]))
+      {
+        /* Insertion sort: CNT is small. */
+        size_t j = need_cnt++;
+        for (; j > 0 && cluster_less (pages[i], need[j - 1]); j--)
+          need[j] = need[j - 1];
+        need[j] = pages[i];
+      }
+  if (need_cnt < 2)
+    return;
+
+  lock_acquire (&swap_lock);
+  first = bitmap_scan_and_flip_next_fit (swap_bitmap, &slot_cursor,
+                                         need_cnt, false);
+  if (first != BITMAP_ERROR)
+    {
+      for (i = 0; i < need_cnt; i++)
+        assign_slot (need[i], first + i);
+      cluster_cnt++;
+    }
+  lock_release (&swap_lock);
+}
+
+/* Reads page P's swap slot into its frame, which must be
+   locked. */
+static void
+read_slot (struct page *p)
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+  ASSERT (p->sector != (block_sector_t) -1);
+
+  block_read_multiple (swap_device, p->sector, PAGE_SECTORS, p->frame->base);
+}
+
+/* Swaps in page P, which must have a locked frame
+   (and be swapped out).  P keeps its swap slot, so that it can
+   later be evicted without another write if it stays clean. */
+bool
+swap_in (struct page *p)
+{
+  read_slot (p);
+  page_read_cnt++;
+  return true;
+}
+
+/* Swaps out page P, which must have a locked frame.  Reuses P's
+   swap slot if it already has one.  Returns true if
+   successful, false if no swap slot is available. */
+bool
+swap_out (struct page *p)
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  if (p->sector == (block_sector_t) -1)
+    {
+      size_t slot;
+
+      lock_acquire (&swap_lock);
+      slot = bitmap_scan_and_flip_next_fit (swap_bitmap, &slot_cursor,
+                                            1, false);
+      if (slot != BITMAP_ERROR)
+        assign_slot (p, slot);
+      lock_release (&swap_lock);
+      if (slot == BITMAP_ERROR)
+        return false;
+    }
+
+  block_write_multiple (swap_device, p->sector, PAGE_SECTORS,
+                        p->frame->base);
+  page_write_cnt++;
+  return true;
+}
+
+/* Releases the swap slot held by page P, if any. */
+void
+swap_free (struct page *p)
+{
+  lock_acquire (&swap_lock);
+  if (p->sector != (block_sector_t) -1)
+    {
+      size_t slot = p->sector / PAGE_SECTORS;
+      ASSERT (slot_pages[slot] == p);
+      slot_pages[slot] = NULL;
+      bitmap_reset (swap_bitmap, slot);
+      p->sector = (block_sector_t) -1;
+    }
+  lock_release (&swap_lock);
+}
+
+/* Stores into NEIGHBORS[] the pages of the running process that
+   occupy the up to MAX swap slots nearest to page P's, which
+   must have a slot, and returns the number stored.  Their frames
+   are not locked, so the caller must check whether they are
+   still swapped out. */
+size_t
+swap_neighbors (struct page *p, struct page *neighbors[], size_t max)
+{
+  struct thread *t = thread_current ();
+  size_t slot_cnt = bitmap_size (swap_bitmap);
+  size_t slot, cnt = 0;
+  size_t dist;
+
+  lock_acquire (&swap_lock);
+  ASSERT (p->sector != (block_sector_t) -1);
+  slot = p->sector / PAGE_SECTORS;
+  for (dist = 1; dist <= max && cnt < max; dist++)
+    {
+      bool in_range = false;
+
+      if (slot + dist < slot_cnt)
+        {
+          struct page *q = slot_pages[slot + dist];
+          in_range = true;
+          if (q != NULL && q->thread == t && cnt < max)
+            neighbors[cnt++] = q;
+        }
+      if (dist <= slot)
+        {
+          struct page *q = slot_pages[slot - dist];
+          in_range = true;
+          if (q != NULL && q->thread == t && cnt < max)
+            neighbors[cnt++] = q;
+        }
+      if (!in_range)
+        break;
+    }
+  lock_release (&swap_lock);
+
+  return cnt;
+}
+
+/* Reads in page P, which must have a locked frame and a swap
+   slot, as part of a read-around. */
+bool
+swap_read_around (struct page *p)
+{
+  read_slot (p);
+  read_around_cnt++;
+  return true;
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void)
+{
+  printf ("Swap: %lld page writes, %lld clusters, %lld page reads, "
+          "%lld read-around pages\n",
+          page_write_cnt, cluster_cnt, page_read_cnt, read_around_cnt);
+}
@@ -0,0 +1,23 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+
+/* Maximum number of pages given contiguous slots at once. */
+#define SWAP_CLUSTER_MAX 16
+
+void swap_init (void);
+bool swap_in (struct page *);
+bool swap_out (struct page *);
+void swap_free (struct page *);
+
+void swap_reserve_cluster (struct page *[], size_t cnt);
+size_t swap_neighbors (struct page *, struct page *[], size_t max);
+bool swap_read_around (struct page *);
+
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */